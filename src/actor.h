@@ -766,6 +766,10 @@ public:
 		return static_cast<T *> (FindInventory (RUNTIME_CLASS(T)));
 	}
 
+	// Throws away the FindInventory lookup table. Must be called by anything
+	// that changes the inventory chain other than AddInventory and RemoveInventory.
+	void InvalidateInventoryIndex ();
+
 	// Adds one item of a particular type. Returns NULL if it could not be added.
 	AActor *GiveInventoryType (PClassActor *type);
 
@@ -1125,6 +1129,7 @@ public:
 	int		accuracy, stamina;		// [RH] Strife stats -- [XA] moved here for DECORATE/ACS access.
 
 	AActor			*inext, **iprev;// Links to other mobjs in same bucket
+	AActor			*cnext, **cprev;// Links to other actors of the same class
 	TObjPtr<AActor*> goal;			// Monster's goal if not chasing anything
 	int				waterlevel;		// 0=none, 1=feet, 2=waist, 3=eyes
 	uint8_t			boomwaterlevel;	// splash information for non-swimmable water sectors
@@ -1179,6 +1184,7 @@ public:
 
 	TObjPtr<AActor*>	Inventory;		// [RH] This actor's inventory
 	uint32_t			InventoryID;	// A unique ID to keep track of inventory items
+	struct FInventoryIndex *InventoryIndex;	// Lookup table for long inventories, built by FindInventory and not saved
 
 	uint8_t smokecounter;
 	uint8_t FloatBobPhase;
@@ -1245,10 +1251,15 @@ public:
 	void AddToHash ();
 	void RemoveFromHash ();
 
+	// Per class actor lists, see FActorClassIterator
+	void LinkToClassList ();
+	void UnlinkFromClassList ();
+
 
 private:
-	static AActor *TIDHash[128];
-	static inline int TIDHASH (int key) { return key & 127; }
+	enum { TIDHASHSIZE = 1024 };
+	static AActor *TIDHash[TIDHASHSIZE];
+	static inline int TIDHASH (int key) { return key & (TIDHASHSIZE - 1); }
 public:
 	static FSharedStringArena mStringPropertyData;
 private:
@@ -1510,7 +1521,7 @@ public:
 		if (id == 0)
 			return NULL;
 		if (!base)
-			base = AActor::TIDHash[id & 127];
+			base = AActor::TIDHash[AActor::TIDHASH(id)];
 		else
 			base = base->inext;
 
@@ -1529,6 +1540,50 @@ private:
 	int id;
 };
 
+// Iterates over the actors of one class, and unless 'exact' is set also those
+// of its subclasses, using the per class lists. It returns the same actors as
+// a class filtered TThinkerIterator with the default statnum but only visits
+// matching ones. The order is different, so only use this where the order
+// does not matter, i.e. for counting or checking if any actor exists.
+class FActorClassIterator
+{
+public:
+	FActorClassIterator (PClassActor *type, bool exact = false);
+	AActor *Next ()
+	{
+		while (next == nullptr)
+		{
+			if (index >= numclasses)
+				return nullptr;
+			next = GetFirst(classes[index++]);
+		}
+		AActor *actor = next;
+		next = actor->cnext;
+		return actor;
+	}
+
+private:
+	static AActor *GetFirst(PClassActor *cls);
+
+	PClassActor *type;
+	PClassActor *const *classes;
+	unsigned numclasses;
+	unsigned index;
+	AActor *next;
+};
+
+template<class T> class TActorClassIterator : public FActorClassIterator
+{
+public:
+	TActorClassIterator (bool exact = false) : FActorClassIterator (RUNTIME_CLASS(T), exact)
+	{
+	}
+	T *Next ()
+	{
+		return static_cast<T *>(FActorClassIterator::Next ());
+	}
+};
+
 template<class T>
 class TActorIterator : public FActorIterator
 {
@@ -0,0 +1,51 @@
+/*
+**  Helpers for the bench console commands
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+*/
+
+#include <stdlib.h>
+#include "doomtype.h"
+#include "templates.h"
+#include "c_dispatch.h"
+#include "v_text.h"
+#include "c_bench.h"
+
+int C_BenchCount(FCommandLine &argv, int index, int defcount, int mincount, int maxcount)
+{
+	if (argv.argc() <= index)
+	{
+		return defcount;
+	}
+	return clamp(atoi(argv[index]), mincount, maxcount);
+}
+
+FString C_BenchSpeedup(uint64_t basetime, uint64_t time)
+{
+	FString str;
+	str.Format("(%.2fx)", time > 0 ? (double)basetime / time : 0.);
+	return str;
+}
+
+void C_BenchCheck(bool mismatch, const char *message)
+{
+	if (mismatch)
+	{
+		Printf(TEXTCOLOR_RED "%s\n", message);
+	}
+}
@@ -0,0 +1,54 @@
+/*
+**  Helpers for the bench console commands
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <limits.h>
+#include "i_time.h"
+#include "zstring.h"
+
+class FCommandLine;
+
+// The bench* commands time an old and a new code path against each other
+// and check that both come to the same result.
+
+// Returns argument 'index' clamped to [mincount, maxcount], or 'defcount'
+// if the command line does not have it.
+int C_BenchCount(FCommandLine &argv, int index, int defcount, int mincount = 1, int maxcount = INT_MAX);
+
+// Calls body(i) for i = 0 .. count-1 and returns the elapsed nanoseconds.
+template<typename Func>
+uint64_t C_BenchTime(int count, Func body)
+{
+	uint64_t start = I_nsTime();
+	for (int i = 0; i < count; i++)
+	{
+		body(i);
+	}
+	return I_nsTime() - start;
+}
+
+// "(2.50x)" for how much faster 'time' is than 'basetime'.
+FString C_BenchSpeedup(uint64_t basetime, uint64_t time);
+
+// Prints the message in red if the two code paths did not agree.
+void C_BenchCheck(bool mismatch, const char *message);
@@ -47,6 +47,7 @@
 
 #include "menu/menu.h"
 #include "vm.h"
+#include "c_bench.h"
 
 struct FLatchedValue
 {
@@ -63,6 +64,14 @@ bool FBaseCVar::m_UseCallback = false;
 
 FBaseCVar *CVars = NULL;
 
+// All named cvars by name, for lookups that don't need the list order. This
+// is created on first use since cvars are constructed during static init.
+static TMap<FName, FBaseCVar *> &CVarHash()
+{
+	static TMap<FName, FBaseCVar *> hash;
+	return hash;
+}
+
 int cvar_defflags;
 
 FBaseCVar::FBaseCVar (const char *var_name, uint32_t flags, void (*callback)(FBaseCVar &))
@@ -94,6 +103,8 @@ FBaseCVar::FBaseCVar (const char *var_name, uint32_t flags, void (*callback)(FBa
 		Name = copystring (var_name);
 		m_Next = CVars;
 		CVars = this;
+		m_HashName = var_name;
+		CVarHash()[m_HashName] = this;
 	}
 
 	if (var)
@@ -121,17 +132,19 @@ FBaseCVar::~FBaseCVar ()
 {
 	if (Name)
 	{
-		FBaseCVar *var, *prev;
+		FBaseCVar **prev = &CVars;
+		while (*prev != nullptr && *prev != this)
+			prev = &(*prev)->m_Next;
+		if (*prev == this)
+			*prev = m_Next;
 
-		var = FindCVar (Name, &prev);
+		// A cvar that replaced this one under the same name keeps its hash entry.
+		// The name is not looked up again here since this may run after the name
+		// table has been destroyed at exit.
+		FBaseCVar **hashed = CVarHash().CheckKey(m_HashName);
+		if (hashed != nullptr && *hashed == this)
+			CVarHash().Remove(m_HashName);
 
-		if (var == this)
-		{
-			if (prev)
-				prev->m_Next = m_Next;
-			else
-				CVars = m_Next;
-		}
 		C_RemoveTabCommand(Name);
 		delete[] Name;
 	}
@@ -1567,13 +1580,12 @@ void C_ForgetCVars (void)
 FBaseCVar *FindCVar (const char *var_name, FBaseCVar **prev)
 {
 	FBaseCVar *var;
-	FBaseCVar *dummy;
 
 	if (var_name == NULL)
 		return NULL;
 
 	if (prev == NULL)
-		prev = &dummy;
+		return FindCVar(FName(var_name, true));
 
 	var = CVars;
 	*prev = NULL;
@@ -1587,46 +1599,45 @@ FBaseCVar *FindCVar (const char *var_name, FBaseCVar **prev)
 	return var;
 }
 
-DEFINE_ACTION_FUNCTION(_CVar, FindCVar)
+FBaseCVar *FindCVar (FName var_name)
 {
-	PARAM_PROLOGUE;
-	PARAM_NAME(name);
-	ACTION_RETURN_POINTER(FindCVar(name, nullptr));
+	FBaseCVar **var = CVarHash().CheckKey(var_name);
+	return var != nullptr ? *var : nullptr;
 }
 
-DEFINE_ACTION_FUNCTION(_CVar, GetCVar)
+DEFINE_ACTION_FUNCTION(_CVar, FindCVar)
 {
 	PARAM_PROLOGUE;
 	PARAM_NAME(name);
-	PARAM_POINTER(plyr, player_t);
-	ACTION_RETURN_POINTER(GetCVar(plyr ? plyr->mo : nullptr, name));
+	ACTION_RETURN_POINTER(FindCVar(name));
 }
 
 FBaseCVar *FindCVarSub (const char *var_name, int namelen)
 {
-	FBaseCVar *var;
-
 	if (var_name == NULL)
 		return NULL;
 
-	var = CVars;
-	while (var)
-	{
-		const char *probename = var->GetName ();
+	return FindCVar(FName(var_name, namelen, true));
+}
 
-		if (strnicmp (probename, var_name, namelen) == 0 &&
-			probename[namelen] == 0)
-		{
-			break;
-		}
-		var = var->m_Next;
+static FBaseCVar *GetUserCVar(int playernum, FName cvarname)
+{
+	if ((unsigned)playernum >= MAXPLAYERS || !playeringame[playernum])
+	{
+		return nullptr;
 	}
-	return var;
+	FBaseCVar **cvar_p = players[playernum].userinfo.CheckKey(cvarname);
+	FBaseCVar *cvar;
+	if (cvar_p == nullptr || (cvar = *cvar_p) == nullptr || (cvar->GetFlags() & CVAR_IGNORE))
+	{
+		return nullptr;
+	}
+	return cvar;
 }
 
-FBaseCVar *GetCVar(AActor *activator, const char *cvarname)
+static FBaseCVar *GetCVar(AActor *activator, FName cvarname)
 {
-	FBaseCVar *cvar = FindCVar(cvarname, nullptr);
+	FBaseCVar *cvar = FindCVar(cvarname);
 	// Either the cvar doesn't exist, or it's for a mod that isn't loaded, so return nullptr.
 	if (cvar == nullptr || (cvar->GetFlags() & CVAR_IGNORE))
 	{
@@ -1647,19 +1658,22 @@ FBaseCVar *GetCVar(AActor *activator, const char *cvarname)
 	}
 }
 
+FBaseCVar *GetCVar(AActor *activator, const char *cvarname)
+{
+	return GetCVar(activator, FName(cvarname, true));
+}
+
 FBaseCVar *GetUserCVar(int playernum, const char *cvarname)
 {
-	if ((unsigned)playernum >= MAXPLAYERS || !playeringame[playernum])
-	{
-		return nullptr;
-	}
-	FBaseCVar **cvar_p = players[playernum].userinfo.CheckKey(FName(cvarname, true));
-	FBaseCVar *cvar;
-	if (cvar_p == nullptr || (cvar = *cvar_p) == nullptr || (cvar->GetFlags() & CVAR_IGNORE))
-	{
-		return nullptr;
-	}
-	return cvar;
+	return GetUserCVar(playernum, FName(cvarname, true));
+}
+
+DEFINE_ACTION_FUNCTION(_CVar, GetCVar)
+{
+	PARAM_PROLOGUE;
+	PARAM_NAME(name);
+	PARAM_POINTER(plyr, player_t);
+	ACTION_RETURN_POINTER(GetCVar(plyr ? plyr->mo : nullptr, name));
 }
 
 //===========================================================================
@@ -1861,6 +1875,64 @@ CCMD (toggle)
 	}
 }
 
+//===========================================================================
+//
+// CCMD benchcvars
+//
+// Times name lookups through the hash against walking the cvar list, with
+// the given number of extra cvars registered for the duration of the test.
+//
+//===========================================================================
+
+// Names are never freed, so all runs share one set of names for the extra cvars.
+static TArray<FName> BenchCVarNames;
+
+CCMD (benchcvars)
+{
+	int extra = C_BenchCount(argv, 1, 1000, 0, 4096);
+
+	for (int i = BenchCVarNames.Size(); i < extra; i++)
+	{
+		FString name;
+		name.Format("__benchcvar%d", i);
+		BenchCVarNames.Push(name);
+	}
+
+	TArray<FBaseCVar *> temp;
+	for (int i = 0; i < extra; i++)
+	{
+		const char *name = BenchCVarNames[i].GetChars();
+		if (FindCVar(name, nullptr) == nullptr)
+			temp.Push(C_CreateCVar(name, CVAR_Int, CVAR_UNSETTABLE));
+	}
+
+	TArray<FBaseCVar *> vars;
+	TArray<FName> names;
+	for (FBaseCVar *var = CVars; var != nullptr; var = var->GetNext())
+	{
+		vars.Push(var);
+		names.Push(var->GetName());
+	}
+
+	const int lookups = 20000;
+	unsigned count = vars.Size();
+	bool mismatch = false;
+	FBaseCVar *prev;
+
+	uint64_t listtime = C_BenchTime(lookups, [&](int i) { mismatch |= FindCVar(vars[i % count]->GetName(), &prev) != vars[i % count]; });
+	uint64_t stringtime = C_BenchTime(lookups, [&](int i) { mismatch |= FindCVar(vars[i % count]->GetName(), nullptr) != vars[i % count]; });
+	uint64_t nametime = C_BenchTime(lookups, [&](int i) { mismatch |= FindCVar(names[i % count]) != vars[i % count]; });
+
+	Printf("%u cvars, %d lookups:  list %.3f ms  string hash %.3f ms %s  name hash %.3f ms %s\n",
+		count, lookups, listtime * 1e-6,
+		stringtime * 1e-6, C_BenchSpeedup(listtime, stringtime).GetChars(),
+		nametime * 1e-6, C_BenchSpeedup(listtime, nametime).GetChars());
+	C_BenchCheck(mismatch, "Hashed and list lookups returned different cvars!");
+
+	for (auto var : temp)
+		delete var;
+}
+
 void FBaseCVar::ListVars (const char *filter, bool plain)
 {
 	FBaseCVar *var = CVars;
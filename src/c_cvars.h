@@ -157,6 +157,7 @@ private:
 
 	void (*m_Callback)(FBaseCVar &);
 	FBaseCVar *m_Next;
+	FName m_HashName;
 
 	static bool m_UseCallback;
 	static bool m_DoNoSet;
@@ -165,6 +166,7 @@ private:
 	friend void C_ReadCVars (uint8_t **demo_p);
 	friend void C_BackupCVars (void);
 	friend FBaseCVar *FindCVar (const char *var_name, FBaseCVar **prev);
+	friend FBaseCVar *FindCVar (FName var_name);
 	friend FBaseCVar *FindCVarSub (const char *var_name, int namelen);
 	friend void UnlatchCVars (void);
 	friend void DestroyCVarsFlagged (uint32_t flags);
@@ -189,8 +191,10 @@ void C_ReadCVars (uint8_t **demo_p);
 // cvars the demo might change.
 void C_BackupCVars (void);
 
-// Finds a named cvar
+// Finds a named cvar. Passing prev walks the list to find the preceding cvar,
+// otherwise the lookup goes through the name hash.
 FBaseCVar *FindCVar (const char *var_name, FBaseCVar **prev);
+FBaseCVar *FindCVar (FName var_name);
 FBaseCVar *FindCVarSub (const char *var_name, int namelen);
 
 // Used for ACS and DECORATE.
@@ -0,0 +1,336 @@
+//-----------------------------------------------------------------------------
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+//-----------------------------------------------------------------------------
+//
+//
+// DESCRIPTION: Per-tic and per-frame timing report for -timedemo.
+//
+// Samples the existing cycle_t clocks of the playsim, the VM, the garbage
+// collector and the renderers once per tic or frame and writes them out
+// when the demo ends, so that runs can be compared across builds.
+//
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <algorithm>
+
+#include "doomtype.h"
+#include "stats.h"
+#include "tarray.h"
+#include "zstring.h"
+#include "doomstat.h"
+#include "version.h"
+#include "g_levellocals.h"
+#include "d_benchreport.h"
+#include "hwrenderer/utility/hw_clock.h"
+#include "polyrenderer/poly_renderer.h"
+
+extern cycle_t ThinkCycles, ActionCycles, ParticleCycles, WorldTickCycles;
+extern cycle_t GCStepCycles;
+extern cycle_t FrameCycles;
+extern cycle_t VMCycles[10];
+extern int VMCalls[10];
+extern int ThinkCount;
+
+namespace swrenderer
+{
+	extern cycle_t WallCycles, PlaneCycles, MaskedCycles, DrawerWaitCycles;
+}
+
+//==========================================================================
+//
+// Column definitions
+//
+// Clocks that are reset by their owner every tic or frame are read
+// directly. Clocks that only ever accumulate (VM, GC) are sampled
+// before and after the tic and the difference is reported.
+//
+//==========================================================================
+
+struct FBenchColumn
+{
+	const char *Name;
+	double (*Sample)();
+	bool Accumulating;
+};
+
+static const FBenchColumn TicColumns[] =
+{
+	{ "think",      []() { return ThinkCycles.TimeMS(); }, false },
+	{ "action",     []() { return ActionCycles.TimeMS(); }, false },
+	{ "particles",  []() { return ParticleCycles.TimeMS(); }, false },
+	{ "worldtick",  []() { return WorldTickCycles.TimeMS(); }, false },
+	{ "thinkers",   []() { return (double)ThinkCount; }, false },
+	{ "vm",         []() { return VMCycles[0].TimeMS(); }, true },
+	{ "vmcalls",    []() { return (double)VMCalls[0]; }, true },
+	{ "gc",         []() { return GCStepCycles.TimeMS(); }, true },
+};
+
+static const FBenchColumn FrameColumns[] =
+{
+	{ "frame",      []() { return FrameCycles.TimeMS(); }, false },
+	{ "sw_walls",   []() { return swrenderer::WallCycles.TimeMS(); }, false },
+	{ "sw_planes",  []() { return swrenderer::PlaneCycles.TimeMS(); }, false },
+	{ "sw_masked",  []() { return swrenderer::MaskedCycles.TimeMS(); }, false },
+	{ "sw_drawers", []() { return swrenderer::DrawerWaitCycles.TimeMS(); }, false },
+	{ "poly_cull",  []() { return PolyCullCycles.TimeMS(); }, false },
+	{ "poly_opaque",[]() { return PolyOpaqueCycles.TimeMS(); }, false },
+	{ "poly_masked",[]() { return PolyMaskedCycles.TimeMS(); }, false },
+	{ "poly_drawers",[]() { return PolyDrawerWaitCycles.TimeMS(); }, false },
+	{ "hw_bsp",     []() { return Bsp.TimeMS(); }, false },
+	{ "hw_render",  []() { return RenderAll.TimeMS(); }, false },
+	{ "hw_process", []() { return ProcessAll.TimeMS(); }, false },
+	{ "hw_portals", []() { return PortalAll.TimeMS(); }, false },
+	{ "hw_drawcalls",[]() { return drawcalls.TimeMS(); }, false },
+	{ "hw_postprocess",[]() { return PostProcess.TimeMS(); }, false },
+};
+
+enum
+{
+	NUM_TIC_COLUMNS = countof(TicColumns),
+	NUM_FRAME_COLUMNS = countof(FrameColumns),
+};
+
+//==========================================================================
+//
+// Sample storage
+//
+// Rows are stored flat: gametic, total time, then one value per column.
+//
+//==========================================================================
+
+static FString ReportFile;
+static bool ReportActive;
+static TArray<double> TicRows;
+static TArray<double> FrameRows;
+static double TicStart[NUM_TIC_COLUMNS];
+static cycle_t TicCycles;
+
+void D_StartBenchReport(const char *filename)
+{
+	ReportFile = filename;
+	ReportActive = true;
+	TicRows.Clear();
+	FrameRows.Clear();
+}
+
+bool D_BenchReportActive()
+{
+	return ReportActive;
+}
+
+void D_BenchBeginTic()
+{
+	if (!ReportActive) return;
+
+	for (int i = 0; i < NUM_TIC_COLUMNS; i++)
+	{
+		if (TicColumns[i].Accumulating) TicStart[i] = TicColumns[i].Sample();
+	}
+	ParticleCycles.Reset();
+	WorldTickCycles.Reset();
+	TicCycles.Reset();
+	TicCycles.Clock();
+}
+
+void D_BenchEndTic()
+{
+	if (!ReportActive) return;
+
+	TicCycles.Unclock();
+	TicRows.Push(gametic);
+	TicRows.Push(TicCycles.TimeMS());
+	for (int i = 0; i < NUM_TIC_COLUMNS; i++)
+	{
+		double v = TicColumns[i].Sample();
+		if (TicColumns[i].Accumulating) v -= TicStart[i];
+		TicRows.Push(v);
+	}
+}
+
+void D_BenchEndFrame()
+{
+	if (!ReportActive) return;
+
+	FrameRows.Push(gametic);
+	for (int i = 0; i < NUM_FRAME_COLUMNS; i++)
+	{
+		FrameRows.Push(FrameColumns[i].Sample());
+	}
+}
+
+//==========================================================================
+//
+// Summary statistics for one column of a flat row table
+//
+//==========================================================================
+
+struct FBenchSummary
+{
+	double Total, Mean, Median, P95, P99, Max;
+};
+
+static FBenchSummary Summarize(const TArray<double> &rows, unsigned stride, unsigned column)
+{
+	FBenchSummary sum = {};
+	unsigned count = rows.Size() / stride;
+	if (count == 0) return sum;
+
+	TArray<double> values(count, true);
+	for (unsigned i = 0; i < count; i++)
+	{
+		values[i] = rows[i * stride + column];
+		sum.Total += values[i];
+	}
+	std::sort(&values[0], &values[0] + count);
+	sum.Mean = sum.Total / count;
+	sum.Median = values[count / 2];
+	sum.P95 = values[std::min(count - 1, count * 95 / 100)];
+	sum.P99 = values[std::min(count - 1, count * 99 / 100)];
+	sum.Max = values[count - 1];
+	return sum;
+}
+
+//==========================================================================
+//
+// JSON output
+//
+//==========================================================================
+
+static void WriteJsonSummary(FILE *f, const char *name, const TArray<double> &rows, unsigned stride, unsigned column, bool last)
+{
+	FBenchSummary s = Summarize(rows, stride, column);
+	fprintf(f, "      \"%s\": { \"total\": %.4f, \"mean\": %.4f, \"median\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }%s\n",
+		name, s.Total, s.Mean, s.Median, s.P95, s.P99, s.Max, last ? "" : ",");
+}
+
+static void WriteJsonTable(FILE *f, const char *name, const TArray<double> &rows, unsigned stride, bool last)
+{
+	fprintf(f, "  \"%s\": [\n", name);
+	unsigned count = rows.Size() / stride;
+	for (unsigned i = 0; i < count; i++)
+	{
+		fputs("    [", f);
+		for (unsigned j = 0; j < stride; j++)
+		{
+			fprintf(f, j == 0 ? "%.0f" : ", %.4f", rows[i * stride + j]);
+		}
+		fprintf(f, "]%s\n", i + 1 < count ? "," : "");
+	}
+	fprintf(f, "  ]%s\n", last ? "" : ",");
+}
+
+static void WriteJson(FILE *f, int gametics, int realtics)
+{
+	const unsigned ticstride = NUM_TIC_COLUMNS + 2;
+	const unsigned framestride = NUM_FRAME_COLUMNS + 1;
+
+	fputs("{\n", f);
+	fprintf(f, "  \"version\": \"%s\",\n", GetVersionString());
+	fprintf(f, "  \"map\": \"%s\",\n", level.MapName.GetChars());
+	fprintf(f, "  \"gametics\": %d,\n", gametics);
+	fprintf(f, "  \"realtics\": %d,\n", realtics);
+	fprintf(f, "  \"fps\": %.2f,\n", realtics > 0 ? (double)gametics / realtics * TICRATE : 0.);
+
+	fputs("  \"summary\": {\n    \"tic\": {\n", f);
+	WriteJsonSummary(f, "total", TicRows, ticstride, 1, false);
+	for (int i = 0; i < NUM_TIC_COLUMNS; i++)
+	{
+		WriteJsonSummary(f, TicColumns[i].Name, TicRows, ticstride, i + 2, i == NUM_TIC_COLUMNS - 1);
+	}
+	fputs("    },\n    \"frame\": {\n", f);
+	for (int i = 0; i < NUM_FRAME_COLUMNS; i++)
+	{
+		WriteJsonSummary(f, FrameColumns[i].Name, FrameRows, framestride, i + 1, i == NUM_FRAME_COLUMNS - 1);
+	}
+	fputs("    }\n  },\n", f);
+
+	fputs("  \"ticcolumns\": [\"gametic\", \"total\"", f);
+	for (auto &col : TicColumns) fprintf(f, ", \"%s\"", col.Name);
+	fputs("],\n  \"framecolumns\": [\"gametic\"", f);
+	for (auto &col : FrameColumns) fprintf(f, ", \"%s\"", col.Name);
+	fputs("],\n", f);
+
+	WriteJsonTable(f, "tics", TicRows, ticstride, false);
+	WriteJsonTable(f, "frames", FrameRows, framestride, true);
+	fputs("}\n", f);
+}
+
+//==========================================================================
+//
+// CSV output
+//
+// One row per tic or frame; the 'kind' column tells them apart and
+// the columns of the other kind are left empty.
+//
+//==========================================================================
+
+static void WriteCsv(FILE *f)
+{
+	const unsigned ticstride = NUM_TIC_COLUMNS + 2;
+	const unsigned framestride = NUM_FRAME_COLUMNS + 1;
+
+	fputs("kind,gametic,total", f);
+	for (auto &col : TicColumns) fprintf(f, ",%s", col.Name);
+	for (auto &col : FrameColumns) fprintf(f, ",%s", col.Name);
+	fputs("\n", f);
+
+	for (unsigned i = 0; i < TicRows.Size() / ticstride; i++)
+	{
+		const double *row = &TicRows[i * ticstride];
+		fprintf(f, "tic,%.0f", row[0]);
+		for (unsigned j = 1; j < ticstride; j++) fprintf(f, ",%.4f", row[j]);
+		for (int j = 0; j < NUM_FRAME_COLUMNS; j++) fputs(",", f);
+		fputs("\n", f);
+	}
+	for (unsigned i = 0; i < FrameRows.Size() / framestride; i++)
+	{
+		const double *row = &FrameRows[i * framestride];
+		fprintf(f, "frame,%.0f,", row[0]);
+		for (int j = 0; j < NUM_TIC_COLUMNS; j++) fputs(",", f);
+		for (unsigned j = 1; j < framestride; j++) fprintf(f, ",%.4f", row[j]);
+		fputs("\n", f);
+	}
+}
+
+//==========================================================================
+//
+// D_WriteBenchReport
+//
+//==========================================================================
+
+void D_WriteBenchReport(int gametics, int realtics)
+{
+	if (!ReportActive) return;
+	ReportActive = false;
+
+	FILE *f = fopen(ReportFile, "w");
+	if (f == nullptr)
+	{
+		Printf("Could not write benchmark report %s\n", ReportFile.GetChars());
+		return;
+	}
+	if (ReportFile.Len() >= 4 && !stricmp(ReportFile.GetChars() + ReportFile.Len() - 4, ".csv"))
+	{
+		WriteCsv(f);
+	}
+	else
+	{
+		WriteJson(f, gametics, realtics);
+	}
+	fclose(f);
+	Printf("Benchmark report written to %s\n", ReportFile.GetChars());
+}
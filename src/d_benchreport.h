@@ -0,0 +1,16 @@
+#ifndef __D_BENCHREPORT_H__
+#define __D_BENCHREPORT_H__
+
+// Machine-readable timing report for -timedemo playback.
+// Enabled with -benchreport <file>; the extension selects JSON or CSV output.
+
+void D_StartBenchReport(const char *filename);
+bool D_BenchReportActive();
+
+void D_BenchBeginTic();
+void D_BenchEndTic();
+void D_BenchEndFrame();
+
+void D_WriteBenchReport(int gametics, int realtics);
+
+#endif
@@ -72,6 +72,7 @@
 #include "r_utility.h"
 #include "r_sky.h"
 #include "d_main.h"
+#include "d_benchreport.h"
 #include "d_dehacked.h"
 #include "cmdlib.h"
 #include "v_text.h"
@@ -934,6 +935,7 @@ void D_Display ()
 	}
 	cycles.Unclock();
 	FrameCycles = cycles;
+	D_BenchEndFrame();
 }
 
 //==========================================================================
@@ -1007,12 +1009,14 @@ void D_DoomLoop ()
 					D_DoAdvanceDemo ();
 				C_Ticker ();
 				M_Ticker ();
+				D_BenchBeginTic ();
 				G_Ticker ();
 				// [RH] Use the consoleplayer's camera to update sounds
 				S_UpdateSounds (players[consoleplayer].camera);	// move positional sounds
 				gametic++;
 				maketic++;
 				GC::CheckGC ();
+				D_BenchEndTic ();
 				Net_NewMakeTic ();
 			}
 			else
@@ -2635,6 +2639,17 @@ void D_DoomMain (void)
 				G_LoadGame (file);
 			}
 
+			v = Args->CheckValue("-synclog");
+			if (v != NULL)
+			{
+				G_StartSyncLog(v, false);
+			}
+			v = Args->CheckValue("-synccheck");
+			if (v != NULL)
+			{
+				G_StartSyncLog(v, true);
+			}
+
 			v = Args->CheckValue("-playdemo");
 			if (v != NULL)
 			{
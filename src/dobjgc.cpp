@@ -73,6 +73,7 @@
 #include "intermission/intermission.h"
 #include "g_levellocals.h"
 #include "events.h"
+#include "stats.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -135,6 +136,8 @@ extern DThinker *NextToThink;
 
 // PUBLIC DATA DEFINITIONS -------------------------------------------------
 
+cycle_t GCStepCycles;
+
 namespace GC
 {
 size_t AllocBytes;
@@ -455,6 +458,7 @@ static size_t SingleStep()
 
 void Step()
 {
+	GCStepCycles.Clock();
 	size_t lim = (GCSTEPSIZE/100) * StepMul;
 	size_t olim;
 	if (lim == 0)
@@ -485,6 +489,7 @@ void Step()
 		SetThreshold();
 	}
 	StepCount++;
+	GCStepCycles.Unclock();
 }
 
 //==========================================================================
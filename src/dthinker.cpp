@@ -42,8 +42,8 @@
 #include "v_text.h"
 
 
-static int ThinkCount;
-static cycle_t ThinkCycles;
+int ThinkCount;
+cycle_t ThinkCycles;
 extern cycle_t BotSupportCycles;
 extern cycle_t ActionCycles;
 extern int BotWTG;
@@ -147,6 +147,23 @@ void DThinker::SaveList(FSerializer &arc, DThinker *node)
 	}
 }
 
+//==========================================================================
+//
+// Actors are only in the per class lists while they are in a statnum that
+// TThinkerIterator searches by default.
+//
+//==========================================================================
+
+static void UpdateClassList(DThinker *thinker, int statnum)
+{
+	if (thinker->IsKindOf(RUNTIME_CLASS(AActor)))
+	{
+		auto actor = static_cast<AActor *>(thinker);
+		if (statnum >= STAT_FIRST_THINKING) actor->LinkToClassList();
+		else actor->UnlinkFromClassList();
+	}
+}
+
 //==========================================================================
 //
 //
@@ -206,11 +223,13 @@ void DThinker::SerializeThinkers(FSerializer &arc, bool hubLoad)
 								else if (thinker->ObjectFlags & OF_JustSpawned)
 								{
 									FreshThinkers[i].AddTail(thinker);
+									UpdateClassList(thinker, i);
 									thinker->PostSerialize();
 								}
 								else
 								{
 									Thinkers[i].AddTail(thinker);
+									UpdateClassList(thinker, i);
 									thinker->PostSerialize();
 								}
 							}
@@ -390,6 +409,7 @@ void DThinker::ChangeStatNum (int statnum)
 		list = &Thinkers[statnum];
 	}
 	list->AddTail(this);
+	UpdateClassList(this, statnum);
 }
 
 static void ChangeStatNum(DThinker *thinker, int statnum)
@@ -40,10 +40,94 @@
 #include "c_dispatch.h"
 #include "d_net.h"
 #include "info.h"
+#include "stats.h"
 
 DStaticEventHandler* E_FirstEventHandler = nullptr;
 DStaticEventHandler* E_LastEventHandler = nullptr;
 
+// first handler that overrides each subscribed event, see DStaticEventHandler::nextSubscriber
+static DStaticEventHandler* E_FirstSubscriber[NUM_EVENT_SUBSCRIPTIONS];
+
+// the virtual a handler has to override to receive each subscribed event
+static const char* const E_SubscriptionVirtuals[NUM_EVENT_SUBSCRIPTIONS] =
+{
+	"WorldThingSpawned",
+	"WorldThingDied",
+	"WorldThingRevived",
+	"WorldThingDamaged",
+	"WorldThingDestroyed",
+	"WorldLinePreActivated",
+	"WorldLineActivated",
+	"WorldSectorDamaged",
+	"WorldLineDamaged",
+	"WorldLightning",
+	"WorldTick",
+	"RenderFrame",
+	"UiTick",
+	"PostUiTick",
+};
+
+#define FOR_EACH_SUBSCRIBER(ev, handler) \
+	for (DStaticEventHandler* handler = E_FirstSubscriber[ev]; handler; handler = handler->nextSubscriber[ev])
+
+// counts and times one dispatch of a subscribed event for the events stat.
+struct FEventStats
+{
+	cycle_t Cycles;
+	int Dispatches;
+	int Calls;
+};
+static FEventStats E_Stats[NUM_EVENT_SUBSCRIPTIONS];
+
+struct FEventDispatch
+{
+	FEventStats &Stats;
+	FEventDispatch(int ev) : Stats(E_Stats[ev]) { Stats.Dispatches++; Stats.Cycles.Clock(); }
+	~FEventDispatch() { Stats.Cycles.Unclock(); }
+	void Call() { Stats.Calls++; }
+};
+
+static bool isEmpty(VMFunction *func);
+
+static bool E_Overrides(DStaticEventHandler* handler, int ev)
+{
+	static unsigned VIndex[NUM_EVENT_SUBSCRIPTIONS];
+	static bool inited = false;
+	if (!inited)
+	{
+		// virtuals that don't exist on the script side (i.e. RenderFrame) get ~0u and never match.
+		for (int i = 0; i < NUM_EVENT_SUBSCRIPTIONS; i++)
+		{
+			auto sym = dyn_cast<PFunction>(RUNTIME_CLASS(DStaticEventHandler)->FindSymbol(E_SubscriptionVirtuals[i], false));
+			VIndex[i] = sym != nullptr ? sym->Variants[0].Implementation->VirtualIndex : ~0u;
+		}
+		inited = true;
+	}
+	auto clss = handler->GetClass();
+	VMFunction *func = clss->Virtuals.Size() > VIndex[ev] ? clss->Virtuals[VIndex[ev]] : nullptr;
+	return func != nullptr && !isEmpty(func);
+}
+
+// rebuild the per-event subscriber chains from the handler list.
+// a handler that gets unlinked while an event is being sent keeps its old links, so the loop continues the same way it would on the main list.
+static void E_UpdateSubscribers()
+{
+	for (int ev = 0; ev < NUM_EVENT_SUBSCRIPTIONS; ev++)
+	{
+		// WorldThingDestroyed is sent in reverse order, like the other teardown events.
+		bool reverse = ev == EVS_WorldThingDestroyed;
+		DStaticEventHandler** link = &E_FirstSubscriber[ev];
+		for (DStaticEventHandler* handler = reverse ? E_LastEventHandler : E_FirstEventHandler; handler; handler = reverse ? handler->prev : handler->next)
+		{
+			if (!E_Overrides(handler, ev))
+				continue;
+			*link = handler;
+			link = &handler->nextSubscriber[ev];
+		}
+		*link = nullptr;
+	}
+}
+
 bool E_RegisterHandler(DStaticEventHandler* handler)
 {
 	if (handler == nullptr || handler->ObjectFlags & OF_EuthanizeMe)
@@ -114,6 +198,7 @@ bool E_RegisterHandler(DStaticEventHandler* handler)
 		handler->ObjectFlags |= OF_Transient;
 	}
 
+	E_UpdateSubscribers();
 	return true;
 }
 
@@ -147,6 +232,7 @@ bool E_UnregisterHandler(DStaticEventHandler* handler)
 		E_LastEventHandler = handler->prev;
 		GC::WriteBarrier(handler->prev);
 	}
+	E_UpdateSubscribers();
 	if (handler->IsStatic())
 	{
 		handler->ObjectFlags &= ~OF_Transient;
@@ -316,8 +402,14 @@ void E_Shutdown(bool map)
 
 #define DEFINE_EVENT_LOOPER(name) void E_##name() \
 { \
-	for (DStaticEventHandler* handler = E_FirstEventHandler; handler; handler = handler->next) \
+	if (E_FirstSubscriber[EVS_##name] == nullptr) \
+		return; \
+	FEventDispatch dispatch(EVS_##name); \
+	FOR_EACH_SUBSCRIBER(EVS_##name, handler) \
+	{ \
+		dispatch.Call(); \
 		handler->name(); \
+	} \
 }
 
 // note for the functions below.
@@ -366,8 +458,16 @@ void E_WorldThingSpawned(AActor* actor)
 	// don't call anything if actor was destroyed on PostBeginPlay/BeginPlay/whatever.
 	if (actor->ObjectFlags & OF_EuthanizeMe)
 		return;
-	for (DStaticEventHandler* handler = E_FirstEventHandler; handler; handler = handler->next)
+	if (E_FirstSubscriber[EVS_WorldThingSpawned] == nullptr)
+		return;
+	FEventDispatch dispatch(EVS_WorldThingSpawned);
+	FOR_EACH_SUBSCRIBER(EVS_WorldThingSpawned, handler)
+	{
+		if (!handler->WantsThing(actor))
+			continue;
+		dispatch.Call();
 		handler->WorldThingSpawned(actor);
+	}
 }
 
 void E_WorldThingDied(AActor* actor, AActor* inflictor)
@@ -375,8 +475,16 @@ void E_WorldThingDied(AActor* actor, AActor* inflictor)
 	// don't call anything if actor was destroyed on PostBeginPlay/BeginPlay/whatever.
 	if (actor->ObjectFlags & OF_EuthanizeMe)
 		return;
-	for (DStaticEventHandler* handler = E_FirstEventHandler; handler; handler = handler->next)
+	if (E_FirstSubscriber[EVS_WorldThingDied] == nullptr)
+		return;
+	FEventDispatch dispatch(EVS_WorldThingDied);
+	FOR_EACH_SUBSCRIBER(EVS_WorldThingDied, handler)
+	{
+		if (!handler->WantsThing(actor))
+			continue;
+		dispatch.Call();
 		handler->WorldThingDied(actor, inflictor);
+	}
 }
 
 void E_WorldThingRevived(AActor* actor)
@@ -384,8 +492,16 @@ void E_WorldThingRevived(AActor* actor)
 	// don't call anything if actor was destroyed on PostBeginPlay/BeginPlay/whatever.
 	if (actor->ObjectFlags & OF_EuthanizeMe)
 		return;
-	for (DStaticEventHandler* handler = E_FirstEventHandler; handler; handler = handler->next)
+	if (E_FirstSubscriber[EVS_WorldThingRevived] == nullptr)
+		return;
+	FEventDispatch dispatch(EVS_WorldThingRevived);
+	FOR_EACH_SUBSCRIBER(EVS_WorldThingRevived, handler)
+	{
+		if (!handler->WantsThing(actor))
+			continue;
+		dispatch.Call();
 		handler->WorldThingRevived(actor);
+	}
 }
 
 void E_WorldThingDamaged(AActor* actor, AActor* inflictor, AActor* source, int damage, FName mod, int flags, DAngle angle)
@@ -393,8 +509,16 @@ void E_WorldThingDamaged(AActor* actor, AActor* inflictor, AActor* source, int d
 	// don't call anything if actor was destroyed on PostBeginPlay/BeginPlay/whatever.
 	if (actor->ObjectFlags & OF_EuthanizeMe)
 		return;
-	for (DStaticEventHandler* handler = E_FirstEventHandler; handler; handler = handler->next)
+	if (E_FirstSubscriber[EVS_WorldThingDamaged] == nullptr)
+		return;
+	FEventDispatch dispatch(EVS_WorldThingDamaged);
+	FOR_EACH_SUBSCRIBER(EVS_WorldThingDamaged, handler)
+	{
+		if (!handler->WantsThing(actor))
+			continue;
+		dispatch.Call();
 		handler->WorldThingDamaged(actor, inflictor, source, damage, mod, flags, angle);
+	}
 }
 
 void E_WorldThingDestroyed(AActor* actor)
@@ -406,33 +530,65 @@ void E_WorldThingDestroyed(AActor* actor)
 	// this is because Destroyed should be reverse of Spawned. we don't want to catch random inventory give failures.
 	if (!(actor->ObjectFlags & OF_Spawned))
 		return;
-	for (DStaticEventHandler* handler = E_LastEventHandler; handler; handler = handler->prev)
+	if (E_FirstSubscriber[EVS_WorldThingDestroyed] == nullptr)
+		return;
+	FEventDispatch dispatch(EVS_WorldThingDestroyed);
+	FOR_EACH_SUBSCRIBER(EVS_WorldThingDestroyed, handler)
+	{
+		if (!handler->WantsThing(actor))
+			continue;
+		dispatch.Call();
 		handler->WorldThingDestroyed(actor);
+	}
 }
 
 void E_WorldLinePreActivated(line_t* line, AActor* actor, int activationType, bool* shouldactivate)
 {
-	for (DStaticEventHandler* handler = E_FirstEventHandler; handler; handler = handler->next)
+	if (E_FirstSubscriber[EVS_WorldLinePreActivated] == nullptr)
+		return;
+	FEventDispatch dispatch(EVS_WorldLinePreActivated);
+	FOR_EACH_SUBSCRIBER(EVS_WorldLinePreActivated, handler)
+	{
+		dispatch.Call();
 		handler->WorldLinePreActivated(line, actor, activationType, shouldactivate);
+	}
 }
 
 void E_WorldLineActivated(line_t* line, AActor* actor, int activationType)
 {
-	for (DStaticEventHandler* handler = E_FirstEventHandler; handler; handler = handler->next)
+	if (E_FirstSubscriber[EVS_WorldLineActivated] == nullptr)
+		return;
+	FEventDispatch dispatch(EVS_WorldLineActivated);
+	FOR_EACH_SUBSCRIBER(EVS_WorldLineActivated, handler)
+	{
+		dispatch.Call();
 		handler->WorldLineActivated(line, actor, activationType);
+	}
 }
 
 int E_WorldSectorDamaged(sector_t* sector, AActor* source, int damage, FName damagetype, int part, DVector3 position, bool isradius)
 {
-	for (DStaticEventHandler* handler = E_FirstEventHandler; handler; handler = handler->next)
+	if (E_FirstSubscriber[EVS_WorldSectorDamaged] == nullptr)
+		return damage;
+	FEventDispatch dispatch(EVS_WorldSectorDamaged);
+	FOR_EACH_SUBSCRIBER(EVS_WorldSectorDamaged, handler)
+	{
+		dispatch.Call();
 		damage = handler->WorldSectorDamaged(sector, source, damage, damagetype, part, position, isradius);
+	}
 	return damage;
 }
 
 int E_WorldLineDamaged(line_t* line, AActor* source, int damage, FName damagetype, int side, DVector3 position, bool isradius)
 {
-	for (DStaticEventHandler* handler = E_FirstEventHandler; handler; handler = handler->next)
+	if (E_FirstSubscriber[EVS_WorldLineDamaged] == nullptr)
+		return damage;
+	FEventDispatch dispatch(EVS_WorldLineDamaged);
+	FOR_EACH_SUBSCRIBER(EVS_WorldLineDamaged, handler)
+	{
+		dispatch.Call();
 		damage = handler->WorldLineDamaged(line, source, damage, damagetype, side, position, isradius);
+	}
 	return damage;
 }
 
@@ -638,6 +794,24 @@ DEFINE_ACTION_FUNCTION(DStaticEventHandler, SetOrder)
 	return 0;
 }
 
+DEFINE_ACTION_FUNCTION(DStaticEventHandler, AddThingFilter)
+{
+	PARAM_SELF_PROLOGUE(DStaticEventHandler);
+	PARAM_CLASS(type, AActor);
+
+	if (type != nullptr && self->ThingFilters.Find(type) == self->ThingFilters.Size())
+		self->ThingFilters.Push(type);
+	return 0;
+}
+
+DEFINE_ACTION_FUNCTION(DStaticEventHandler, ClearThingFilters)
+{
+	PARAM_SELF_PROLOGUE(DStaticEventHandler);
+
+	self->ThingFilters.Clear();
+	return 0;
+}
+
 DEFINE_ACTION_FUNCTION(DEventHandler, SendNetworkEvent)
 {
 	PARAM_PROLOGUE;
@@ -1210,6 +1384,37 @@ void DStaticEventHandler::OnDestroy()
 	Super::OnDestroy();
 }
 
+bool DStaticEventHandler::WantsThing(AActor* actor)
+{
+	if (ThingFilters.Size() == 0)
+		return true;
+	for (PClassActor* type : ThingFilters)
+	{
+		if (actor->IsKindOf(type))
+			return true;
+	}
+	return false;
+}
+
+// per event dispatch counts and time since the stat was last shown.
+ADD_STAT(events)
+{
+	FString out;
+	for (int ev = 0; ev < NUM_EVENT_SUBSCRIPTIONS; ev++)
+	{
+		FEventStats &stats = E_Stats[ev];
+		if (stats.Dispatches > 0)
+		{
+			if (out.Len() > 0) out += "\n";
+			out.AppendFormat("%s: %d sent, %d handler calls, %04.2f ms", E_SubscriptionVirtuals[ev], stats.Dispatches, stats.Calls, stats.Cycles.TimeMS());
+		}
+		stats.Cycles.Reset();
+		stats.Dispatches = stats.Calls = 0;
+	}
+	if (out.Len() == 0) out = "no subscribed events sent";
+	return out;
+}
+
 // console stuff
 // this is kinda like puke, except it distinguishes between local events and playsim events.
 CCMD(event)
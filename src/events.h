@@ -102,6 +102,27 @@ void E_SerializeEvents(FSerializer& arc);
 //
 // ==============================================
 
+// events that are only sent to the handlers that override them
+enum EEventSubscription
+{
+	EVS_WorldThingSpawned,
+	EVS_WorldThingDied,
+	EVS_WorldThingRevived,
+	EVS_WorldThingDamaged,
+	EVS_WorldThingDestroyed,
+	EVS_WorldLinePreActivated,
+	EVS_WorldLineActivated,
+	EVS_WorldSectorDamaged,
+	EVS_WorldLineDamaged,
+	EVS_WorldLightning,
+	EVS_WorldTick,
+	EVS_RenderFrame,
+	EVS_UiTick,
+	EVS_PostUiTick,
+
+	NUM_EVENT_SUBSCRIPTIONS
+};
+
 class DStaticEventHandler : public DObject // make it a part of normal GC process
 {
 	DECLARE_CLASS(DStaticEventHandler, DObject);
@@ -113,12 +134,20 @@ public:
 		next = 0;
 		Order = 0;
 		IsUiProcessor = false;
+		memset(nextSubscriber, 0, sizeof(nextSubscriber));
 	}
 
 	DStaticEventHandler* prev;
 	DStaticEventHandler* next;
 	virtual bool IsStatic() { return true; }
 
+	// next handler in list order that overrides the event. these are rebuilt whenever a handler is registered or unregistered.
+	DStaticEventHandler* nextSubscriber[NUM_EVENT_SUBSCRIPTIONS];
+
+	// if not empty, thing events are only sent for actors derived from one of these classes.
+	TArray<PClassActor*> ThingFilters;
+	bool WantsThing(AActor* actor);
+
 	//
 	int Order;
 	bool IsUiProcessor;
@@ -142,6 +171,7 @@ public:
 		arc("Order", Order);
 		arc("IsUiProcessor", IsUiProcessor);
 		arc("RequireMouse", RequireMouse);
+		arc("ThingFilters", ThingFilters);
 	}
 
 	// destroy handler. this unlinks EventHandler from the list automatically.
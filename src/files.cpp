@@ -33,6 +33,20 @@
 **
 */
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <limits.h>
+
 #include "files.h"
 #include "templates.h"
 
@@ -337,6 +351,80 @@ public:
 
 
 
+//==========================================================================
+//
+// MappedFileReader
+//
+// maps an entire file into memory. Since it is a MemoryReader, resource
+// files opened through it hand out pointers into the mapping instead of
+// copying uncompressed lumps into the cache. The mapping is private
+// copy-on-write so code modifying cached lump data in place does not
+// affect the file on disk.
+//
+//==========================================================================
+
+class MappedFileReader : public MemoryReader
+{
+#ifdef _WIN32
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	HANDLE hMapping = nullptr;
+#endif
+	void *mapping = nullptr;
+
+public:
+	~MappedFileReader()
+	{
+#ifdef _WIN32
+		if (mapping != nullptr) UnmapViewOfFile(mapping);
+		if (hMapping != nullptr) CloseHandle(hMapping);
+		if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+#else
+		if (mapping != nullptr) munmap(mapping, Length);
+#endif
+	}
+
+	bool Open(const char *filename)
+	{
+#ifdef _WIN32
+		hFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (hFile == INVALID_HANDLE_VALUE) return false;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(hFile, &size) || size.QuadPart <= 0 || size.QuadPart > LONG_MAX) return false;
+
+		hMapping = CreateFileMappingA(hFile, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		if (hMapping == nullptr) return false;
+
+		mapping = MapViewOfFile(hMapping, FILE_MAP_COPY, 0, 0, 0);
+		if (mapping == nullptr) return false;
+		Length = (long)size.QuadPart;
+#else
+		int fd = open(filename, O_RDONLY);
+		if (fd < 0) return false;
+
+		struct stat info;
+		if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size <= 0 || info.st_size > LONG_MAX)
+		{
+			close(fd);
+			return false;
+		}
+
+		// The descriptor is not needed anymore once the mapping exists.
+		void *ptr = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (ptr == MAP_FAILED) return false;
+
+		mapping = ptr;
+		Length = (long)info.st_size;
+#endif
+		bufptr = (const char *)mapping;
+		FilePos = 0;
+		return true;
+	}
+};
+
+
+
 //==========================================================================
 //
 // FileReader
@@ -358,6 +446,21 @@ bool FileReader::OpenFile(const char *filename, FileReader::Size start, FileRead
 	return true;
 }
 
+bool FileReader::OpenMappedFile(const char *filename)
+{
+	auto reader = new MappedFileReader;
+	if (!reader->Open(filename))
+	{
+		// Fall back to regular file access, e.g. for empty files or when
+		// running out of address space.
+		delete reader;
+		return OpenFile(filename);
+	}
+	Close();
+	mReader = reader;
+	return true;
+}
+
 bool FileReader::OpenFilePart(FileReader &parent, FileReader::Size start, FileReader::Size length)
 {
 	auto reader = new FileReaderRedirect(parent, (long)start, (long)length);
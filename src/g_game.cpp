@@ -46,6 +46,7 @@
 #include "p_saveg.h"
 #include "p_tick.h"
 #include "d_main.h"
+#include "d_benchreport.h"
 #include "wi_stuff.h"
 #include "hu_stuff.h"
 #include "st_stuff.h"
@@ -94,20 +95,23 @@ void	G_DoPlayDemo (void);
 void	G_DoCompleted (void);
 void	G_DoVictory (void);
 void	G_DoWorldDone (void);
-void	G_DoSaveGame (bool okForQuicksave, FString filename, const char *description);
+void	G_DoSaveGame (bool okForQuicksave, FString filename, const char *description, bool background = false);
 void	G_DoAutoSave ();
+static void G_SyncLogTic ();
 
 void STAT_Serialize(FSerializer &file);
 bool WriteZip(const char *filename, TArray<FString> &filenames, TArray<FCompressedBuffer> &content);
 
 FIntCVar gameskill ("skill", 2, CVAR_SERVERINFO|CVAR_LATCH);
 CVAR(Bool, save_formatted, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// use formatted JSON for saves (more readable but a larger files and a bit slower.
+CVAR(Bool, save_binary, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)	// use the binary format for level snapshots and globals. Ignored if save_formatted is on.
 CVAR (Int, deathmatch, 0, CVAR_SERVERINFO|CVAR_LATCH);
 CVAR (Bool, chasedemo, false, 0);
 CVAR (Bool, storesavepic, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR (Bool, longsavemessages, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR (String, save_dir, "", CVAR_ARCHIVE|CVAR_GLOBALCONFIG);
 CVAR (Bool, cl_waitforsave, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+CVAR (Bool, autosaveasync, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);	// compress and write autosaves on a background thread
 EXTERN_CVAR (Float, con_midtime);
 
 //==========================================================================
@@ -1043,6 +1047,9 @@ void G_Ticker ()
 		AddCommandString (toggle_fullscreen);
 	}
 
+	// report a background save once it has been written
+	G_FinishPendingSave(false);
+
 	// do things to change the game state
 	oldgamestate = gamestate;
 	while (gameaction != ga_nothing)
@@ -1227,6 +1234,8 @@ void G_Ticker ()
 		break;
 	}
 
+	G_SyncLogTic ();
+
 	// [MK] Additional ticker for UI events right after all others
 	E_PostUiTick();
 }
@@ -1807,6 +1816,9 @@ void G_DoLoadGame ()
 	hidecon = gameaction == ga_loadgamehidecon;
 	gameaction = ga_nothing;
 
+	// The file to load may still be being written.
+	G_FinishPendingSave(true);
+
 	std::unique_ptr<FResourceFile> resfile(FResourceFile::OpenResourceFile(savename.GetChars(), true, true));
 	if (resfile == nullptr)
 	{
@@ -2060,7 +2072,7 @@ void G_DoAutoSave ()
 
 	readableTime = myasctime ();
 	description.Format("Autosave %.12s", readableTime + 4);
-	G_DoSaveGame (false, file, description);
+	G_DoSaveGame (false, file, description, autosaveasync);
 }
 
 
@@ -2118,7 +2130,115 @@ static void PutSavePic (FileWriter *file, int width, int height)
 	}
 }
 
-void G_DoSaveGame (bool okForQuicksave, FString filename, const char *description)
+//==========================================================================
+//
+// Background saves
+//
+// Only the capture of the game state has to happen on the game thread.
+// For a background save the compression and writing of the zip is done
+// by a separate thread. G_Ticker checks the result on the game thread
+// once it is done and reports it. The file is the same as the one a
+// normal save would write.
+//
+//==========================================================================
+
+struct FPendingSave
+{
+	std::future<bool> Result;
+	FString Filename;
+	FString Description;
+	bool OkForQuicksave;
+};
+
+static FPendingSave PendingSave;
+
+static void G_ReportSave (bool ok, const FString &filename, const FString &description, bool okForQuicksave)
+{
+	savegameManager.NotifyNewSave (filename, description, okForQuicksave);
+
+	if (ok)
+	{
+		if (longsavemessages) Printf ("%s (%s)\n", GStrings("GGSAVED"), filename.GetChars());
+		else Printf ("%s\n", GStrings("GGSAVED"));
+	}
+	else Printf(PRINT_HIGH, "Save failed\n");
+}
+
+static bool G_VerifySave (const FString &filename)
+{
+	// Check whether the file is ok by trying to open it.
+	FResourceFile *test = FResourceFile::OpenResourceFile(filename, true);
+	if (test == nullptr) return false;
+	delete test;
+	return true;
+}
+
+// Everything a background save needs once the game state has been captured.
+struct FBackgroundSave
+{
+	TArray<FString> Filenames;
+	TArray<FCompressedBuffer> Content;
+	std::shared_ptr<BufferWriter> Savepic;	// Content[0] points into this.
+	std::future<FCompressedBuffer> Info, Globals, Snapshot;
+	int SnapshotSlot;
+
+	bool Write(const FString &filename)
+	{
+		Content[1] = Info.get();
+		Content[2] = Globals.get();
+		FCompressedBuffer levelsnapshot = Snapshot.get();
+		if (SnapshotSlot < 0)
+		{
+			levelsnapshot.Clean();
+		}
+		else if (levelsnapshot.mCompressedSize > 0)
+		{
+			Content[SnapshotSlot] = levelsnapshot;
+		}
+		else
+		{
+			// A normal save would not have listed the level at all.
+			Content.Delete(SnapshotSlot);
+			Filenames.Delete(SnapshotSlot);
+		}
+
+		bool ok = WriteZip(filename, Filenames, Content);
+
+		// Unlike in a normal save all buffers but the savepic are owned by this.
+		for (unsigned i = 1; i < Content.Size(); i++)
+		{
+			Content[i].Clean();
+		}
+		return ok;
+	}
+};
+
+//==========================================================================
+//
+// G_FinishPendingSave
+//
+// Reports a background save once it has been written. With 'wait' this
+// blocks until it is, which must be done before anything the save thread
+// might still use goes away.
+//
+//==========================================================================
+
+void G_FinishPendingSave (bool wait)
+{
+	if (!PendingSave.Result.valid()) return;
+	if (!wait && PendingSave.Result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+
+	// The file is opened here rather than on the save thread, since the resource file code is not thread safe.
+	bool ok = PendingSave.Result.get() && G_VerifySave(PendingSave.Filename);
+	G_ReportSave(ok, PendingSave.Filename, PendingSave.Description, PendingSave.OkForQuicksave);
+}
+
+static void G_ShutdownPendingSave ()
+{
+	G_FinishPendingSave(true);
+}
+
+void G_DoSaveGame (bool okForQuicksave, FString filename, const char *description, bool background)
 {
 	TArray<FCompressedBuffer> savegame_content;
 	TArray<FString> savegame_filenames;
@@ -2137,13 +2257,19 @@ void G_DoSaveGame (bool okForQuicksave, FString filename, const char *descriptio
 		filename = G_BuildSaveName ("demosave." SAVEGAME_EXT, -1);
 	}
 
+	// Never have two saves writing at once.
+	G_FinishPendingSave(true);
+
 	if (cl_waitforsave)
 		I_FreezeTime(true);
 
+	// The level snapshot gets compressed while the savepic and the globals are created.
+	std::future<FCompressedBuffer> snapshot;
+
 	insave = true;
 	try
 	{
-		G_SnapshotLevel();
+		snapshot = G_SnapshotLevelAsync();
 	}
 	catch(CRecoverableError &err)
 	{
@@ -2165,21 +2291,22 @@ void G_DoSaveGame (bool okForQuicksave, FString filename, const char *descriptio
 		throw;
 	}
 
-	BufferWriter savepic;
+	auto savepic = std::make_shared<BufferWriter>();
 	FSerializer savegameinfo;		// this is for displayable info about the savegame
 	FSerializer savegameglobals;	// and this for non-level related info that must be saved.
 
 	savegameinfo.OpenWriter(true);
-	savegameglobals.OpenWriter(save_formatted);
+	if (save_binary && !save_formatted) savegameglobals.OpenBinaryWriter();
+	else savegameglobals.OpenWriter(save_formatted);
 
 	SaveVersion = SAVEVER;
-	PutSavePic(&savepic, SAVEPICWIDTH, SAVEPICHEIGHT);
+	PutSavePic(savepic.get(), SAVEPICWIDTH, SAVEPICHEIGHT);
 	mysnprintf(buf, countof(buf), GAMENAME " %s", GetVersionString());
 	// put some basic info into the PNG so that this isn't lost when the image gets extracted.
-	M_AppendPNGText(&savepic, "Software", buf);
-	M_AppendPNGText(&savepic, "Title", description);
-	M_AppendPNGText(&savepic, "Current Map", level.MapName);
-	M_FinishPNG(&savepic);
+	M_AppendPNGText(savepic.get(), "Software", buf);
+	M_AppendPNGText(savepic.get(), "Title", description);
+	M_AppendPNGText(savepic.get(), "Current Map", level.MapName);
+	M_FinishPNG(savepic.get());
 
 	int ver = SAVEVER;
 	savegameinfo.AddString("Software", buf)
@@ -2219,40 +2346,74 @@ void G_DoSaveGame (bool okForQuicksave, FString filename, const char *descriptio
 		savegameglobals("nextskill", NextSkill);
 	}
 
-	auto picdata = savepic.GetBuffer();
+	auto picdata = savepic->GetBuffer();
 	FCompressedBuffer bufpng = { picdata->Size(), picdata->Size(), METHOD_STORED, 0, static_cast<unsigned int>(crc32(0, &(*picdata)[0], picdata->Size())), (char*)&(*picdata)[0] };
 
 	savegame_content.Push(bufpng);
 	savegame_filenames.Push("savepic.png");
+
+	BackupSaveName = filename;
+
+	if (background)
+	{
+		// From here on the game state is no longer needed. The other levels'
+		// snapshots get copied since they may change before the save is written.
+		auto info = savegameinfo.GetCompressedOutputAsync();
+		auto globals = savegameglobals.GetCompressedOutputAsync();
+		int snapshotslot = -1;
+
+		savegame_content.Push({ 0,0,0,0,0,nullptr });
+		savegame_filenames.Push("info.json");
+		savegame_content.Push({ 0,0,0,0,0,nullptr });
+		savegame_filenames.Push("globals.json");
+		G_WriteSnapshots (savegame_filenames, savegame_content, &snapshotslot);
+
+		auto save = std::make_shared<FBackgroundSave>();
+		save->Filenames = std::move(savegame_filenames);
+		save->Content = std::move(savegame_content);
+		save->Savepic = savepic;
+		save->Info = std::move(info);
+		save->Globals = std::move(globals);
+		save->Snapshot = std::move(snapshot);
+		save->SnapshotSlot = snapshotslot;
+
+		PendingSave.Filename = filename;
+		PendingSave.Description = description;
+		PendingSave.OkForQuicksave = okForQuicksave;
+		PendingSave.Result = std::async(std::launch::async, [=]() { return save->Write(filename); });
+
+		// Do not leave the save thread running into static destruction.
+		static bool shutdownregistered;
+		if (!shutdownregistered)
+		{
+			atterm(G_ShutdownPendingSave);
+			shutdownregistered = true;
+		}
+
+		insave = false;
+
+		if (cl_waitforsave)
+			I_FreezeTime(false);
+		return;
+	}
+
 	savegame_content.Push(savegameinfo.GetCompressedOutput());
 	savegame_filenames.Push("info.json");
 	savegame_content.Push(savegameglobals.GetCompressedOutput());
 	savegame_filenames.Push("globals.json");
 
+	level.info->Snapshot = snapshot.get();
 	G_WriteSnapshots (savegame_filenames, savegame_content);
 	
 
 	WriteZip(filename, savegame_filenames, savegame_content);
 
-	savegameManager.NotifyNewSave (filename, description, okForQuicksave);
-
 	// delete the JSON buffers we created just above. Everything else will
 	// either still be needed or taken care of automatically.
 	savegame_content[1].Clean();
 	savegame_content[2].Clean();
 
-	// Check whether the file is ok by trying to open it.
-	FResourceFile *test = FResourceFile::OpenResourceFile(filename, true);
-	if (test != nullptr)
-	{
-		delete test;
-		if (longsavemessages) Printf ("%s (%s)\n", GStrings("GGSAVED"), filename.GetChars());
-		else Printf ("%s\n", GStrings("GGSAVED"));
-	}
-	else Printf(PRINT_HIGH, "Save failed\n");
-
-
-	BackupSaveName = filename;
+	G_ReportSave(G_VerifySave(filename), filename, description, okForQuicksave);
 
 	// We don't need the snapshot any longer.
 	level.info->Snapshot.Clean();
@@ -2744,11 +2905,111 @@ void G_TimeDemo (const char* name)
 	timingdemo = true;
 	singletics = true;
 
+	const char *report = Args->CheckValue ("-benchreport");
+	if (report != NULL)
+	{
+		D_StartBenchReport (report);
+	}
+
 	defdemoname = name;
 	gameaction = (gameaction == ga_loadgame) ? ga_loadgameplaydemo : ga_playdemo;
 }
 
 
+//==========================================================================
+//
+// Demo sync log
+//
+// -synclog <file> writes a checksum of the playsim state for every tic,
+// -synccheck <file> compares the current run against such a log and
+// reports the first tic where they differ. This allows verifying that a
+// change to the playsim keeps existing demos in sync. The log is closed
+// when the demo that is being played back or recorded ends.
+//
+//==========================================================================
+
+static FILE *SyncLogFile;
+static bool SyncLogCheck;
+static bool SyncLogFailed;
+
+void G_StartSyncLog (const char *filename, bool check)
+{
+	G_StopSyncLog ();
+	SyncLogFile = fopen (filename, check ? "r" : "w");
+	if (SyncLogFile == NULL)
+	{
+		Printf ("Could not open sync log %s\n", filename);
+		return;
+	}
+	SyncLogCheck = check;
+	SyncLogFailed = false;
+}
+
+void G_StopSyncLog ()
+{
+	if (SyncLogFile != NULL)
+	{
+		if (SyncLogCheck && !SyncLogFailed)
+		{
+			Printf ("Sync check passed.\n");
+		}
+		fclose (SyncLogFile);
+		SyncLogFile = NULL;
+	}
+}
+
+uint32_t G_PlaysimChecksum ()
+{
+	uint32_t crc = FRandom::StaticSumSeeds ();
+	auto add = [&](const auto &value)
+	{
+		crc = AddCRC32 (crc, (const uint8_t *)&value, sizeof(value));
+	};
+
+	TThinkerIterator<AActor> it;
+	AActor *ac;
+	while ((ac = it.Next ()))
+	{
+		add (ac->Pos ());
+		add (ac->Vel);
+		add (ac->Angles.Yaw.Degrees);
+		add (ac->Angles.Pitch.Degrees);
+		add (ac->health);
+		add (ac->tics);
+		add (ac->flags.GetValue ());
+		add (ac->flags2.GetValue ());
+	}
+	return crc;
+}
+
+static void G_SyncLogTic ()
+{
+	if (SyncLogFile == NULL || gamestate != GS_LEVEL)
+		return;
+
+	uint32_t sum = G_PlaysimChecksum ();
+	if (!SyncLogCheck)
+	{
+		fprintf (SyncLogFile, "%d %08x\n", gametic, sum);
+		return;
+	}
+	if (SyncLogFailed)
+		return;
+
+	int tic;
+	unsigned int expected;
+	if (fscanf (SyncLogFile, "%d %x", &tic, &expected) != 2)
+	{
+		Printf (TEXTCOLOR_RED "Sync log ended at tic %d\n", gametic);
+		SyncLogFailed = true;
+	}
+	else if (tic != gametic || expected != sum)
+	{
+		Printf (TEXTCOLOR_RED "Desync at tic %d: expected %08x (tic %d), got %08x\n", gametic, expected, tic, sum);
+		SyncLogFailed = true;
+	}
+}
+
 /*
 ===================
 =
@@ -2771,6 +3032,8 @@ bool G_CheckDemoStatus (void)
 		extern int starttime;
 		int endtime = 0;
 
+		G_StopSyncLog ();
+
 		if (timingdemo)
 			endtime = I_GetTime () - starttime;
 
@@ -2798,6 +3061,7 @@ bool G_CheckDemoStatus (void)
 				// Trying to get back to a stable state after timing a demo
 				// seems to cause problems. I don't feel like fixing that
 				// right now.
+				D_WriteBenchReport (gametic, endtime);
 				I_FatalError ("timed %i gametics in %i realtics (%.1f fps)\n"
 							  "(This is not really an error.)", gametic,
 							  endtime, (float)gametic/(float)endtime*(float)TICRATE);
@@ -2822,6 +3086,7 @@ bool G_CheckDemoStatus (void)
 	{
 		uint8_t *formlen;
 
+		G_StopSyncLog ();
 		WriteByte (DEM_STOP, &demo_p);
 
 		if (demo_compress)
@@ -58,6 +58,9 @@ void G_DoLoadGame (void);
 // Called by M_Responder.
 void G_SaveGame (const char *filename, const char *description);
 
+// Reports a background save once it is written, optionally waiting for it.
+void G_FinishPendingSave (bool wait);
+
 // Only called by startup code.
 void G_RecordDemo (const char* name);
 
@@ -67,6 +70,11 @@ void G_PlayDemo (char* name);
 void G_TimeDemo (const char* name);
 bool G_CheckDemoStatus (void);
 
+// Per-tic playsim checksums for verifying demo sync (-synclog/-synccheck)
+void G_StartSyncLog (const char *filename, bool check);
+void G_StopSyncLog ();
+uint32_t G_PlaysimChecksum ();
+
 void G_WorldDone (void);
 
 void G_Ticker (void);
@@ -91,6 +91,7 @@ void STAT_StartNewGame(const char *lev);
 void STAT_ChangeLevel(const char *newl);
 
 EXTERN_CVAR(Bool, save_formatted)
+EXTERN_CVAR(Bool, save_binary)
 EXTERN_CVAR (Float, sv_gravity)
 EXTERN_CVAR (Float, sv_aircontrol)
 EXTERN_CVAR (Int, disableautosave)
@@ -1641,6 +1642,11 @@ void G_AirControlChanged ()
 //
 //==========================================================================
 
+static bool G_OpenSnapshotWriter (FSerializer &arc)
+{
+	return save_binary && !save_formatted ? arc.OpenBinaryWriter() : arc.OpenWriter(save_formatted);
+}
+
 void G_SnapshotLevel ()
 {
 	level.info->Snapshot.Clean();
@@ -1649,7 +1655,7 @@ void G_SnapshotLevel ()
 	{
 		FSerializer arc;
 
-		if (arc.OpenWriter(save_formatted))
+		if (G_OpenSnapshotWriter(arc))
 		{
 			SaveVersion = SAVEVER;
 			G_SerializeLevel(arc, false);
@@ -1658,6 +1664,27 @@ void G_SnapshotLevel ()
 	}
 }
 
+//==========================================================================
+//
+// Same as above, but only the capture is done right away. Compression
+// is left to a worker thread and the caller has to store the result in
+// level.info->Snapshot once it needs it.
+//
+//==========================================================================
+
+std::future<FCompressedBuffer> G_SnapshotLevelAsync ()
+{
+	level.info->Snapshot.Clean();
+
+	FSerializer arc;
+	if (level.info->isValid() && G_OpenSnapshotWriter(arc))
+	{
+		SaveVersion = SAVEVER;
+		G_SerializeLevel(arc, false);
+	}
+	return arc.GetCompressedOutputAsync();
+}
+
 //==========================================================================
 //
 // Unarchives the current level based on its snapshot
@@ -1723,28 +1750,43 @@ void G_UnSnapshotLevel (bool hubLoad)
 //
 //==========================================================================
 
-void G_WriteSnapshots(TArray<FString> &filenames, TArray<FCompressedBuffer> &buffers)
+static void G_WriteSnapshot(level_info_t *info, const char *format, TArray<FString> &filenames, TArray<FCompressedBuffer> &buffers, int *pendingslot)
 {
-	unsigned int i;
-	FString filename;
+	FCompressedBuffer buff = info->Snapshot;
 
-	for (i = 0; i < wadlevelinfos.Size(); i++)
+	if (pendingslot != nullptr && info == level.info)
 	{
-		if (wadlevelinfos[i].Snapshot.mCompressedSize > 0)
-		{
-			filename.Format("%s.map.json", wadlevelinfos[i].MapName.GetChars());
-			filename.ToLower();
-			filenames.Push(filename);
-			buffers.Push(wadlevelinfos[i].Snapshot);
-		}
+		// The current level's snapshot is still being compressed.
+		*pendingslot = buffers.Size();
+		buff = { 0,0,0,0,0,nullptr };
+	}
+	else if (buff.mCompressedSize == 0)
+	{
+		return;
+	}
+	else if (pendingslot != nullptr)
+	{
+		// A background save may outlive the snapshot, so it gets its own copy.
+		buff.mBuffer = new char[buff.mCompressedSize];
+		memcpy(buff.mBuffer, info->Snapshot.mBuffer, buff.mCompressedSize);
 	}
-	if (TheDefaultLevelInfo.Snapshot.mCompressedSize > 0)
+
+	FString filename;
+	filename.Format(format, info->MapName.GetChars());
+	filename.ToLower();
+	filenames.Push(filename);
+	buffers.Push(buff);
+}
+
+void G_WriteSnapshots(TArray<FString> &filenames, TArray<FCompressedBuffer> &buffers, int *pendingslot)
+{
+	if (pendingslot != nullptr) *pendingslot = -1;
+
+	for (unsigned int i = 0; i < wadlevelinfos.Size(); i++)
 	{
-		filename.Format("%s.mapd.json", TheDefaultLevelInfo.MapName.GetChars());
-		filename.ToLower();
-		filenames.Push(filename);
-		buffers.Push(TheDefaultLevelInfo.Snapshot);
+		G_WriteSnapshot(&wadlevelinfos[i], "%s.map.json", filenames, buffers, pendingslot);
 	}
+	G_WriteSnapshot(&TheDefaultLevelInfo, "%s.mapd.json", filenames, buffers, pendingslot);
 }
 
 //==========================================================================
@@ -34,6 +34,7 @@
 #ifndef __G_LEVEL_H__
 #define __G_LEVEL_H__
 
+#include <future>
 #include "doomtype.h"
 #include "vectors.h"
 #include "sc_man.h"
@@ -526,9 +527,12 @@ void G_ParseMapInfo (FString basemapinfo);
 void G_ClearSnapshots (void);
 void P_RemoveDefereds ();
 void G_SnapshotLevel (void);
+std::future<FCompressedBuffer> G_SnapshotLevelAsync (void);
 void G_UnSnapshotLevel (bool keepPlayers);
 void G_ReadSnapshots (FResourceFile *);
-void G_WriteSnapshots (TArray<FString> &, TArray<FCompressedBuffer> &);
+// With pendingslot set, the current level gets an empty entry whose index is
+// returned there, and all other buffers are copies owned by the caller.
+void G_WriteSnapshots (TArray<FString> &, TArray<FCompressedBuffer> &, int *pendingslot = nullptr);
 void G_WriteVisited(FSerializer &arc);
 void G_ReadVisited(FSerializer &arc);
 void G_ClearHubInfo();
@@ -36,6 +36,7 @@
 #include <assert.h>
 #include "templates.h"
 #include "g_level.h"
+#include "g_game.h"
 #include "w_wad.h"
 #include "cmdlib.h"
 #include "v_video.h"
@@ -191,6 +192,9 @@ cluster_info_t *FindClusterInfo (int cluster)
 
 void G_ClearSnapshots (void)
 {
+	// Finish a background save of the game that is being left first.
+	G_FinishPendingSave(true);
+
 	for (unsigned int i = 0; i < wadlevelinfos.Size(); i++)
 	{
 		wadlevelinfos[i].Snapshot.Clean();
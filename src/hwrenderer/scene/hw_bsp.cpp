@@ -409,7 +409,6 @@ void HWDrawInfo::RenderThings(subsector_t * sub, sector_t * sector)
 
 void HWDrawInfo::DoSubsector(subsector_t * sub)
 {
-	unsigned int i;
 	sector_t * sector;
 	sector_t * fakesector;
 	
@@ -461,16 +460,18 @@ void HWDrawInfo::DoSubsector(subsector_t * sub)
 	{
 		SetupSprite.Clock();
 
-		for (i = ParticlesInSubsec[sub->Index()]; i != NO_PARTICLE; i = Particles[i].snext)
+		int ssnum = sub->Index();
+		for (uint32_t j = ParticlesInSubsec[ssnum]; j < ParticlesInSubsec[ssnum + 1]; j++)
 		{
+			particle_t *particle = &Particles[ParticleBins[j]];
 			if (mClipPortal)
 			{
-				int clipres = mClipPortal->ClipPoint(Particles[i].Pos);
+				int clipres = mClipPortal->ClipPoint(particle->Pos);
 				if (clipres == PClip_InFront) continue;
 			}
 
 			GLSprite sprite;
-			sprite.ProcessParticle(this, &Particles[i], fakesector);
+			sprite.ProcessParticle(this, particle, fakesector);
 		}
 		SetupSprite.Unclock();
 	}
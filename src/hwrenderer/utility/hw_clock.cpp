@@ -41,6 +41,7 @@
 #include "g_levellocals.h"
 #include "hw_clock.h"
 #include "i_time.h"
+#include "d_benchreport.h"
 
 glcycle_t RenderWall,SetupWall,ClipWall;
 glcycle_t RenderFlat,SetupFlat;
@@ -205,6 +206,6 @@ bool glcycle_t::active = false;
 void  checkBenchActive()
 {
 	FStat *stat = FStat::FindStat("rendertimes");
-	glcycle_t::active = ((stat != NULL && stat->isActive()) || printstats);
+	glcycle_t::active = ((stat != NULL && stat->isActive()) || printstats || D_BenchReportActive());
 }
 
@@ -267,6 +267,11 @@ struct FActorInfo
 
 	uint8_t DefaultStateUsage = 0; // state flag defaults for blocks without a qualifier.
 
+	// Actors of exactly this class in the thinking statnums, linked through AActor::cnext.
+	AActor *FirstActor = nullptr;
+	// This class and all classes derived from it, filled in by the first FActorClassIterator that needs it.
+	TArray<PClassActor *> Subclasses;
+
 	FActorInfo() {}
 	FActorInfo(const FActorInfo & other)
 	{
@@ -43,11 +43,22 @@
 
 #include "doomdata.h"
 #include "nodebuild.h"
+#include "c_cvars.h"
+#include "threadpool.h"
+
+// Evaluate splitter candidates on the shared thread pool. The result is
+// identical to the serial builder, so this does not affect demo sync.
+CVAR(Bool, nb_parallel, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 
 const int MaxSegs = 64;
 const int SplitCost = 8;
 const int AAPreference = 16;
 
+// Splitter evaluation is only spread across threads if at least this many
+// seg classifications (candidates * segs in set) need to be done. Below that
+// the task overhead outweighs the gain.
+const unsigned int MinParallelWork = 32768;
+
 #if 0
 #define D(x) x
 #else
@@ -57,6 +68,7 @@ const int AAPreference = 16;
 FNodeBuilder::FNodeBuilder(FLevel &level)
 : Level(level), GLNodes(false), SegsStuffed(0)
 {
+	Parallel = nb_parallel;
 	VertexMap = NULL;
 	OldVertexTable = NULL;
 }
@@ -66,6 +78,7 @@ FNodeBuilder::FNodeBuilder (FLevel &level,
 							bool makeGLNodes)
 	: Level(level), GLNodes(makeGLNodes), SegsStuffed(0)
 {
+	Parallel = nb_parallel;
 	VertexMap = new FVertexMap (*this, Level.MinX, Level.MinY, Level.MaxX, Level.MaxY);
 	FindUsedVertices (Level.Vertices, Level.NumVertices);
 	MakeSegsFromSides ();
@@ -444,6 +457,7 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 	int bestvalue;
 	uint32_t bestseg;
 	uint32_t seg;
+	unsigned int segsInSet;
 	bool nosplitters = false;
 
 	bestvalue = 0;
@@ -451,11 +465,14 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 
 	seg = set;
 	stepleft = 0;
+	segsInSet = 0;
 
 	memset (&PlaneChecked[0], 0, PlaneChecked.Size());
+	Candidates.Clear ();
 
 	D(Printf (PRINT_LOG, "Processing set %d\n", set));
 
+	// Collect one seg per plane as a splitter candidate.
 	while (seg != DWORD_MAX)
 	{
 		FPrivSeg *pseg = &Segs[seg];
@@ -473,28 +490,35 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 				}
 
 				stepleft = step;
-				SetNodeFromSeg (node, pseg);
-
-				int value = Heuristic (node, set, nosplit);
-
-				D(Printf (PRINT_LOG, "Seg %5d, ld %d (%5d,%5d)-(%5d,%5d) scores %d\n", seg, Segs[seg].linedef, node.x>>16, node.y>>16,
-					(node.x+node.dx)>>16, (node.y+node.dy)>>16, value));
-
-				if (value > bestvalue)
-				{
-					bestvalue = value;
-					bestseg = seg;
-				}
-				else if (value < 0)
-				{
-					nosplitters = true;
-				}
+				Candidates.Push (seg);
 			}
 		}
 
+		segsInSet++;
 		seg = pseg->next;
 	}
 
+	ScoreCandidates (set, nosplit, segsInSet);
+
+	// Pick the best one in list order so that ties resolve the same way
+	// no matter how the scores were computed.
+	for (unsigned int i = 0; i < Candidates.Size(); ++i)
+	{
+		int value = CandidateScores[i];
+
+		D(Printf (PRINT_LOG, "Seg %5d, ld %d scores %d\n", Candidates[i], Segs[Candidates[i]].linedef, value));
+
+		if (value > bestvalue)
+		{
+			bestvalue = value;
+			bestseg = Candidates[i];
+		}
+		else if (value < 0)
+		{
+			nosplitters = true;
+		}
+	}
+
 	if (bestseg == DWORD_MAX)
 	{ // No lines split any others into two sets, so this is a convex region.
 	D(Printf (PRINT_LOG, "set %d, step %d, nosplit %d has no good splitter (%d)\n", set, step, nosplit, nosplitters));
@@ -508,13 +532,49 @@ int FNodeBuilder::SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg
 	return 1;
 }
 
+// Fills CandidateScores with the Heuristic() value of every seg in Candidates.
+// Heuristic() only reads the seg and vertex arrays, so the candidates can be
+// scored concurrently as long as each thread has its own scratch lists.
+void FNodeBuilder::ScoreCandidates (uint32_t set, bool nosplit, unsigned int segsInSet)
+{
+	unsigned int count = Candidates.Size();
+	CandidateScores.Resize (count);
+
+	if (!Parallel || count < 2 || count * segsInSet < MinParallelWork)
+	{
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			node_t node;
+			SetNodeFromSeg (node, &Segs[Candidates[i]]);
+			CandidateScores[i] = Heuristic (node, set, nosplit);
+		}
+		return;
+	}
+
+	FThreadPool *pool = FThreadPool::Instance();
+	unsigned int slots = pool->NumWorkers() + 1;
+	if (Scratch.Size() < slots)
+	{
+		// Slot 0 is for the calling thread when it is not a pool worker.
+		Scratch.Resize (slots);
+	}
+
+	pool->ParallelFor (0, count, 1, [&](int i)
+	{
+		FHeuristicScratch &scratch = Scratch[FThreadPool::CurrentWorker() + 1];
+		node_t node;
+		SetNodeFromSeg (node, &Segs[Candidates[i]]);
+		CandidateScores[i] = Heuristic (node, set, nosplit, scratch.Touched, scratch.Colinear);
+	});
+}
+
 // Given a splitter (node), returns a score based on how "good" the resulting
 // split in a set of segs is. Higher scores are better. -1 means this splitter
 // splits something it shouldn't and will only be returned if honorNoSplit is
 // true. A score of 0 means that the splitter does not split any of the segs
 // in the set.
 
-int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
+int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit, TArray<int> &touched, TArray<int> &colinear)
 {
 	// Set the initial score above 0 so that near vertex anti-weighting is less likely to produce a negative score.
 	int score = 1000000;
@@ -529,8 +589,8 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 	unsigned int max, m2, p, q;
 	double frac;
 
-	Touched.Clear ();
-	Colinear.Clear ();
+	touched.Clear ();
+	colinear.Clear ();
 
 	while (i != DWORD_MAX)
 	{
@@ -556,32 +616,32 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 			{
 				if ((sidev[0] | sidev[1]) != 0)
 				{
-					max = Touched.Size();
+					max = touched.Size();
 					for (p = 0; p < max; ++p)
 					{
-						if (Touched[p] == test->loopnum)
+						if (touched[p] == test->loopnum)
 						{
 							break;
 						}
 					}
 					if (p == max)
 					{
-						Touched.Push (test->loopnum);
+						touched.Push (test->loopnum);
 					}
 				}
 				else
 				{
-					max = Colinear.Size();
+					max = colinear.Size();
 					for (p = 0; p < max; ++p)
 					{
-						if (Colinear[p] == test->loopnum)
+						if (colinear[p] == test->loopnum)
 						{
 							break;
 						}
 					}
 					if (p == max)
 					{
-						Colinear.Push (test->loopnum);
+						colinear.Push (test->loopnum);
 					}
 				}
 			}
@@ -698,8 +758,8 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 	// seg of that sector must be crossing the container's corner and does not
 	// actually split the container.
 
-	max = Touched.Size ();
-	m2 = Colinear.Size ();
+	max = touched.Size ();
+	m2 = colinear.Size ();
 
 	// If honorNoSplit is false, then both these lists will be empty.
 
@@ -712,10 +772,10 @@ int FNodeBuilder::Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
 
 	for (p = 0; p < max; ++p)
 	{
-		int look = Touched[p];
+		int look = touched[p];
 		for (q = 0; q < m2; ++q)
 		{
-			if (look == Colinear[q])
+			if (look == colinear[q])
 			{
 				break;
 			}
@@ -1070,3 +1130,55 @@ void FNodeBuilder::PrintSet (int l, uint32_t set)
 	}
 	Printf (PRINT_LOG, "*\n");
 }
+
+bool FNodeBuilder::SameTree (const FNodeBuilder &other) const
+{
+	if (Nodes.Size() != other.Nodes.Size() ||
+		Segs.Size() != other.Segs.Size() ||
+		Vertices.Size() != other.Vertices.Size() ||
+		Subsectors.Size() != other.Subsectors.Size() ||
+		SubsectorSets.Size() != other.SubsectorSets.Size())
+	{
+		return false;
+	}
+	for (unsigned int i = 0; i < Nodes.Size(); ++i)
+	{
+		const node_t &a = Nodes[i], &b = other.Nodes[i];
+		if (a.x != b.x || a.y != b.y || a.dx != b.dx || a.dy != b.dy ||
+			a.intchildren[0] != b.intchildren[0] || a.intchildren[1] != b.intchildren[1] ||
+			memcmp (a.nb_bbox, b.nb_bbox, sizeof(a.nb_bbox)) != 0)
+		{
+			return false;
+		}
+	}
+	for (unsigned int i = 0; i < Segs.Size(); ++i)
+	{
+		const FPrivSeg &a = Segs[i], &b = other.Segs[i];
+		if (a.v1 != b.v1 || a.v2 != b.v2 || a.linedef != b.linedef || a.sidedef != b.sidedef || a.next != b.next)
+		{
+			return false;
+		}
+	}
+	for (unsigned int i = 0; i < Vertices.Size(); ++i)
+	{
+		if (Vertices[i].x != other.Vertices[i].x || Vertices[i].y != other.Vertices[i].y)
+		{
+			return false;
+		}
+	}
+	for (unsigned int i = 0; i < Subsectors.Size(); ++i)
+	{
+		if (Subsectors[i].firstline != other.Subsectors[i].firstline || Subsectors[i].numlines != other.Subsectors[i].numlines)
+		{
+			return false;
+		}
+	}
+	for (unsigned int i = 0; i < SubsectorSets.Size(); ++i)
+	{
+		if (SubsectorSets[i] != other.SubsectorSets[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
@@ -237,6 +237,10 @@ public:
 	void Extract(FLevelLocals &level);
 	const int *GetOldVertexTable();
 
+	// Compares the generated tree against another builder's, for verifying
+	// that the parallel build matches the serial one.
+	bool SameTree(const FNodeBuilder &other) const;
+
 	// These are used for building sub-BSP trees for polyobjects.
 	void Clear();
 	void AddPolySegs(FPolySeg *segs, int numsegs);
@@ -267,6 +271,18 @@ private:
 
 	TArray<int> Touched;	// Loops a splitter touches on a vertex
 	TArray<int> Colinear;	// Loops with edges colinear to a splitter
+
+	// Splitter candidates of the current set and their scores, for evaluating
+	// them in parallel. Every pool worker gets its own Touched/Colinear pair.
+	struct FHeuristicScratch
+	{
+		TArray<int> Touched;
+		TArray<int> Colinear;
+	};
+	TArray<uint32_t> Candidates;
+	TArray<int> CandidateScores;
+	TArray<FHeuristicScratch> Scratch;
+	bool Parallel;			// Evaluate splitters on the thread pool?
 	FEventTree Events;		// Vertices intersected by the current splitter
 
 	TArray<FSplitSharer> SplitSharers;	// Segs colinear with the current splitter
@@ -297,7 +313,12 @@ private:
 	bool ShoveSegBehind (uint32_t set, node_t &node, uint32_t seg, uint32_t mate);	int SelectSplitter (uint32_t set, node_t &node, uint32_t &splitseg, int step, bool nosplit);
 	void SplitSegs (uint32_t set, node_t &node, uint32_t splitseg, uint32_t &outset0, uint32_t &outset1, unsigned int &count0, unsigned int &count1);
 	uint32_t SplitSeg (uint32_t segnum, int splitvert, int v1InFront);
-	int Heuristic (node_t &node, uint32_t set, bool honorNoSplit);
+	int Heuristic (node_t &node, uint32_t set, bool honorNoSplit)
+	{
+		return Heuristic (node, set, honorNoSplit, Touched, Colinear);
+	}
+	int Heuristic (node_t &node, uint32_t set, bool honorNoSplit, TArray<int> &touched, TArray<int> &colinear);
+	void ScoreCandidates (uint32_t set, bool nosplit, unsigned int segsInSet);
 
 	// Returns:
 	//	0 = seg is in front
@@ -3705,6 +3705,25 @@ do_count:
 			}
 		}
 	}
+	else if (kind != NULL)
+	{
+		// Only the actors of this class need to be looked at.
+		FActorClassIterator iterator (kind, true);
+		while ( (actor = iterator.Next ()) )
+		{
+			if (actor->health > 0)
+			{
+				if (tag == -1 || tagManager.SectorHasTag(actor->Sector, tag))
+				{
+					// Don't count items in somebody's inventory
+					if (actor->IsMapActor())
+					{
+						count++;
+					}
+				}
+			}
+		}
+	}
 	else
 	{
 		TThinkerIterator<AActor> iterator;
@@ -6828,6 +6847,231 @@ inline int getshort (int *&pc)
 	return res;
 }
 
+#ifdef HAVE_VM_JIT
+//============================================================================
+//
+// ACS JIT
+//
+// Straight runs of stack arithmetic and script variable accesses are
+// compiled to native code once they have been entered often enough. Every
+// other instruction, including all jumps, is left to the interpreter, so a
+// run always ends where the interpreter has to take over again.
+//
+//============================================================================
+
+CVAR(Bool, acs_jit, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+// Runs each compiled block on a copy of the script state and compares the
+// result with the interpreter's.
+CVAR(Bool, acs_jitcheck, false, 0)
+
+enum
+{
+	JITSTATE_Threshold = 16,
+	JITSTATE_None = 254,
+	JITSTATE_Block = 255,
+
+	JIT_MAXRUN = 64,
+};
+
+static void DecodeJitRun(FACSJitBlock &block, int *pc, const uint8_t *dataend, ACSFormat fmt)
+{
+	int depth = 0;
+
+	block.Ops.Clear();
+	block.NumInstructions = 0;
+	block.MinDepth = 0;
+	block.MaxDepth = 0;
+	block.NumLocals = 0;
+
+	auto pop = [&](int count) { depth -= count; block.MinDepth = MIN(block.MinDepth, depth); };
+	auto push = [&](int count) { depth += count; block.MaxDepth = MAX(block.MaxDepth, depth); };
+	auto useLocal = [&](int index) { block.NumLocals = MAX(block.NumLocals, index + 1); };
+
+	// The longest instruction is PUSH5BYTES with a four byte opcode.
+	while (block.NumInstructions < JIT_MAXRUN && (const uint8_t *)pc + 9 <= dataend)
+	{
+		int *start = pc;
+		int pcd;
+		if (fmt == ACS_LittleEnhanced)
+		{
+			pcd = getbyte(pc);
+			if (pcd >= 256-16)
+			{
+				pcd = (256-16) + ((pcd - (256-16)) << 8) + getbyte(pc);
+			}
+		}
+		else
+		{
+			pcd = NEXTWORD;
+		}
+
+		EACSJitOp op;
+		int arg = 0;
+		switch (pcd)
+		{
+		case PCD_NOP:
+			block.NumInstructions++;
+			continue;
+
+		case PCD_PUSHNUMBER:
+			block.Ops.Push({ ACSJIT_Push, uallong(pc[0]) });
+			pc++;
+			push(1);
+			block.NumInstructions++;
+			continue;
+
+		case PCD_PUSHBYTE:
+		case PCD_PUSH2BYTES:
+		case PCD_PUSH3BYTES:
+		case PCD_PUSH4BYTES:
+		case PCD_PUSH5BYTES:
+		{
+			int count = pcd == PCD_PUSHBYTE ? 1 : pcd - PCD_PUSH2BYTES + 2;
+			for (int i = 0; i < count; i++)
+			{
+				block.Ops.Push({ ACSJIT_Push, ((uint8_t *)pc)[i] });
+			}
+			pc = (int *)((uint8_t *)pc + count);
+			push(count);
+			block.NumInstructions++;
+			continue;
+		}
+
+		case PCD_DUP:				pop(1); push(2); op = ACSJIT_Dup; break;
+		case PCD_SWAP:				pop(2); push(2); op = ACSJIT_Swap; break;
+		case PCD_DROP:				pop(1); op = ACSJIT_Drop; break;
+
+		case PCD_ADD:				pop(2); push(1); op = ACSJIT_Add; break;
+		case PCD_SUBTRACT:			pop(2); push(1); op = ACSJIT_Subtract; break;
+		case PCD_MULTIPLY:			pop(2); push(1); op = ACSJIT_Multiply; break;
+		case PCD_EQ:				pop(2); push(1); op = ACSJIT_EQ; break;
+		case PCD_NE:				pop(2); push(1); op = ACSJIT_NE; break;
+		case PCD_LT:				pop(2); push(1); op = ACSJIT_LT; break;
+		case PCD_GT:				pop(2); push(1); op = ACSJIT_GT; break;
+		case PCD_LE:				pop(2); push(1); op = ACSJIT_LE; break;
+		case PCD_GE:				pop(2); push(1); op = ACSJIT_GE; break;
+		case PCD_ANDLOGICAL:		pop(2); push(1); op = ACSJIT_AndLogical; break;
+		case PCD_ORLOGICAL:			pop(2); push(1); op = ACSJIT_OrLogical; break;
+		case PCD_ANDBITWISE:		pop(2); push(1); op = ACSJIT_AndBitwise; break;
+		case PCD_ORBITWISE:			pop(2); push(1); op = ACSJIT_OrBitwise; break;
+		case PCD_EORBITWISE:		pop(2); push(1); op = ACSJIT_EorBitwise; break;
+
+		case PCD_NEGATELOGICAL:		pop(1); push(1); op = ACSJIT_NegateLogical; break;
+		case PCD_NEGATEBINARY:		pop(1); push(1); op = ACSJIT_NegateBinary; break;
+		case PCD_UNARYMINUS:		pop(1); push(1); op = ACSJIT_UnaryMinus; break;
+
+		case PCD_PUSHSCRIPTVAR:		op = ACSJIT_PushLocal; break;
+		case PCD_ASSIGNSCRIPTVAR:	op = ACSJIT_AssignLocal; break;
+		case PCD_ADDSCRIPTVAR:		op = ACSJIT_AddLocal; break;
+		case PCD_SUBSCRIPTVAR:		op = ACSJIT_SubLocal; break;
+		case PCD_MULSCRIPTVAR:		op = ACSJIT_MulLocal; break;
+		case PCD_INCSCRIPTVAR:		op = ACSJIT_IncLocal; break;
+		case PCD_DECSCRIPTVAR:		op = ACSJIT_DecLocal; break;
+
+		default:
+			// Division and the shifts stay with the interpreter because of
+			// division by zero and out of range shift counts.
+			pc = start;
+			block.End = pc;
+			block.Delta = depth;
+			return;
+		}
+
+		if (op >= ACSJIT_PushLocal)
+		{
+			// The stack effect is only counted once the index is known to be good,
+			// so that a run that ends here keeps the depth of the instructions before.
+			arg = NEXTBYTE;
+			if (arg < 0)
+			{
+				pc = start;
+				break;
+			}
+			useLocal(arg);
+			if (op == ACSJIT_PushLocal) push(1);
+			else if (op != ACSJIT_IncLocal && op != ACSJIT_DecLocal) pop(1);
+		}
+		block.Ops.Push({ op, arg });
+		block.NumInstructions++;
+	}
+	block.End = pc;
+	block.Delta = depth;
+}
+
+//============================================================================
+//
+// FBehavior :: GetJitBlock
+//
+// Returns the compiled run that starts at pc, or nullptr if the interpreter
+// has to execute the next instruction.
+//
+//============================================================================
+
+FACSJitBlock *FBehavior::GetJitBlock(int *pc)
+{
+	uint32_t ofs = PC2Ofs(pc);
+	if (ofs >= (uint32_t)DataSize)
+	{
+		return nullptr;
+	}
+	if (JitState.Size() == 0)
+	{
+		JitState.Resize(DataSize);
+		memset(&JitState[0], 0, DataSize);
+	}
+
+	uint8_t &state = JitState[ofs];
+	if (state == JITSTATE_None)
+	{
+		return nullptr;
+	}
+	if (state < JITSTATE_Threshold - 1)
+	{
+		state++;
+		return nullptr;
+	}
+
+	FACSJitBlock *block;
+	if (state == JITSTATE_Block)
+	{
+		block = JitBlocks.CheckKey(ofs);
+		if (block->Failed)
+		{
+			state = JITSTATE_None;
+			return nullptr;
+		}
+		if (block->Generation == JitACSGeneration())
+		{
+			return block;
+		}
+	}
+	else
+	{
+		block = &JitBlocks[ofs];
+		DecodeJitRun(*block, pc, Data + DataSize, Format);
+		// A single instruction is not worth the call.
+		if (block->NumInstructions < 2 || block->Ops.Size() == 0)
+		{
+			JitBlocks.Remove(ofs);
+			state = JITSTATE_None;
+			return nullptr;
+		}
+		block->Failed = false;
+	}
+
+	block->Func = JitCompileACS(block->Ops);
+	block->Generation = JitACSGeneration();
+	if (block->Func == nullptr)
+	{
+		JitBlocks.Remove(ofs);
+		state = JITSTATE_None;
+		return nullptr;
+	}
+	state = JITSTATE_Block;
+	return block;
+}
+#endif
+
 static bool CharArrayParms(int &capacity, int &offset, int &a, FACSStackMemory& Stack, int &sp, bool ranged)
 {
 	if (ranged)
@@ -6941,6 +7185,14 @@ int DLevelScript::RunScript ()
 	const char *lookup;
 	int optstart = -1;
 	int temp;
+#ifdef HAVE_VM_JIT
+	const bool usejit = acs_jit;
+	FACSJitBlock *checkblock = nullptr;
+	int *checkpc = nullptr;
+	int checkleft = 0;
+	int checksp = 0;
+	TArray<int32_t> checkstack, checklocals;
+#endif
 
 	while (state == SCRIPT_Running)
 	{
@@ -6951,6 +7203,66 @@ int DLevelScript::RunScript ()
 			break;
 		}
 
+#ifdef HAVE_VM_JIT
+		if (checkblock != nullptr && --checkleft == 0)
+		{
+			// The interpreter has executed the block; compare its result with
+			// what the native code did to the copy.
+			bool localsonstack = locals.GetPointer() >= Stack.Pointer() && locals.GetPointer() < Stack.Pointer() + Stack.Size();
+			if (pc != checkblock->End || sp != checksp ||
+				memcmp(Stack.Pointer(), &checkstack[0], Stack.Size() * sizeof(int32_t)) != 0 ||
+				(!localsonstack && checkblock->NumLocals > 0 &&
+				 memcmp(locals.GetPointer(), &checklocals[0], checkblock->NumLocals * sizeof(int32_t)) != 0))
+			{
+				Printf (TEXTCOLOR_RED "ACS JIT mismatch in %s at offset %u, block disabled\n",
+					ScriptPresentation(script).GetChars(), activeBehavior->PC2Ofs(checkpc));
+				checkblock->Failed = true;
+			}
+			checkblock = nullptr;
+		}
+
+		if (usejit && checkblock == nullptr)
+		{
+			FACSJitBlock *block = activeBehavior->GetJitBlock(pc);
+			if (block != nullptr &&
+				runaway + block->NumInstructions - 1 <= 2000000 &&
+				sp + block->MinDepth >= 0 && sp + block->MaxDepth <= (int)Stack.Size() &&
+				(size_t)block->NumLocals <= locals.Size())
+			{
+				if (!acs_jitcheck)
+				{
+					block->Func(Stack.Pointer() + sp, locals.GetPointer());
+					sp += block->Delta;
+					pc = block->End;
+					runaway += block->NumInstructions - 1;
+					continue;
+				}
+
+				// Run the native code on a copy and let the interpreter go on
+				// with the real state. Function locals live on the stack, so
+				// they have to be redirected into the copy of it.
+				checkstack.Resize(Stack.Size());
+				memcpy(&checkstack[0], Stack.Pointer(), Stack.Size() * sizeof(int32_t));
+				int32_t *lp = locals.GetPointer();
+				if (lp >= Stack.Pointer() && lp < Stack.Pointer() + Stack.Size())
+				{
+					lp = &checkstack[lp - Stack.Pointer()];
+				}
+				else if (block->NumLocals > 0)
+				{
+					checklocals.Resize(block->NumLocals);
+					memcpy(&checklocals[0], lp, block->NumLocals * sizeof(int32_t));
+					lp = &checklocals[0];
+				}
+				block->Func(&checkstack[sp], lp);
+				checkblock = block;
+				checkpc = pc;
+				checkleft = block->NumInstructions;
+				checksp = sp + block->Delta;
+			}
+		}
+#endif
+
 		if (fmt == ACS_LittleEnhanced)
 		{
 			pcd = getbyte(pc);
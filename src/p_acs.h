@@ -200,6 +200,16 @@ public:
 		return memory;
 	}
 
+	int32_t *GetPointer()
+	{
+		return memory;
+	}
+
+	size_t Size() const
+	{
+		return count;
+	}
+
 private:
 	int32_t *memory;
 	size_t count;
@@ -344,6 +354,25 @@ enum
 
 enum ACSFormat { ACS_Old, ACS_Enhanced, ACS_LittleEnhanced, ACS_Unknown };
 
+#ifdef HAVE_VM_JIT
+#include "jit_acs.h"
+
+// A straight run of simple instructions that was compiled to native code.
+struct FACSJitBlock
+{
+	TArray<FACSJitOp> Ops;
+	ACSJitFunc Func;
+	int *End;				// pc after the run
+	int NumInstructions;	// for the runaway counter
+	int Delta;				// change of sp after the run
+	int MinDepth;			// lowest stack slot relative to sp the run touches
+	int MaxDepth;			// one past the highest slot
+	int NumLocals;			// one past the highest local variable index
+	int Generation;
+	bool Failed;
+};
+#endif
+
 class FBehavior
 {
 public:
@@ -378,6 +407,9 @@ public:
 	ACSProfileInfo *GetFunctionProfileData(int index) { return index >= 0 && index < NumFunctions ? &FunctionProfileData[index] : NULL; }
 	ACSProfileInfo *GetFunctionProfileData(ScriptFunction *func) { return GetFunctionProfileData((int)(func - (ScriptFunction *)Functions)); }
 	const char *LookupString (uint32_t index) const;
+#ifdef HAVE_VM_JIT
+	FACSJitBlock *GetJitBlock (int *pc);
+#endif
 
 	BoundsCheckingArray<int32_t *, NUM_MAPVARS> MapVars;
 
@@ -420,6 +452,10 @@ private:
 	uint32_t LibraryID;
 	char ModuleName[9];
 	TArray<int> JumpPoints;
+#ifdef HAVE_VM_JIT
+	TArray<uint8_t> JitState;	// per byte of Data: hit count, then JITSTATE_None or JITSTATE_Block
+	TMap<uint32_t, FACSJitBlock> JitBlocks;
+#endif
 
 	static TArray<FBehavior *> StaticModules;
 
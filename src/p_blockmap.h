@@ -41,11 +41,19 @@ struct FBlockmap
 	double				bmaporgy;		// origin of block map
 	FBlockNode**		blocklinks; 	// for thing chains
 
+	// number of thing links in each group of SUPERBLOCKSIZE x SUPERBLOCKSIZE blocks,
+	// so that the spatial queries can skip empty parts of the map quickly.
+	int*				superblockcounts;
+	int					superwidth;
+	int					superheight;	// in superblocks
+
 	// mapblocks are used to check movement
 	// against lines and things
 	enum
 	{
-		MAPBLOCKUNITS = 128
+		MAPBLOCKUNITS = 128,
+		SUPERBLOCKSHIFT = 2,
+		SUPERBLOCKSIZE = 1 << SUPERBLOCKSHIFT
 	};
 
 	inline int GetBlockX(double xpos)
@@ -64,6 +72,16 @@ struct FBlockmap
 			(unsigned int)y < (unsigned int)bmapheight);
 	}
 
+	inline int GetSuperBlock(int x, int y) const
+	{
+		return (y >> SUPERBLOCKSHIFT) * superwidth + (x >> SUPERBLOCKSHIFT);
+	}
+
+	inline int GetSuperBlock(int blockindex) const
+	{
+		return GetSuperBlock(blockindex % bmapwidth, blockindex / bmapwidth);
+	}
+
 	inline int *GetLines(int x, int y) const
 	{
 		// There is an extra entry at the beginning of every block.
@@ -87,6 +105,11 @@ struct FBlockmap
 			delete[] blocklinks;
 			blocklinks = NULL;
 		}
+		if (superblockcounts != NULL)
+		{
+			delete[] superblockcounts;
+			superblockcounts = NULL;
+		}
 	}
 
 };
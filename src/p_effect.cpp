@@ -59,10 +59,10 @@ FRandom pr_railtrail("RailTrail");
 #define FADEFROMTTL(a)	(1.f/(a))
 
 // [RH] particle globals
-uint32_t			ActiveParticles;
-uint32_t			InactiveParticles;
+uint32_t			NumActiveParticles;
 TArray<particle_t>	Particles;
-TArray<uint16_t>	ParticlesInSubsec;
+TArray<uint32_t>	ParticlesInSubsec;
+TArray<uint32_t>	ParticleBins;
 
 static int grey1, grey2, grey3, grey4, red, green, blue, yellow, black,
 		   red1, green1, blue1, yellow1, purple, purple1, white,
@@ -105,12 +105,10 @@ static const struct ColorList {
 inline particle_t *NewParticle (void)
 {
 	particle_t *result = nullptr;
-	if (InactiveParticles != NO_PARTICLE)
+	if (NumActiveParticles < Particles.Size())
 	{
-		result = &Particles[InactiveParticles];
-		InactiveParticles = result->tnext;
-		result->tnext = ActiveParticles;
-		ActiveParticles = uint32_t(result - Particles.Data());
+		result = &Particles[NumActiveParticles++];
+		memset (result, 0, sizeof(particle_t));
 	}
 	return result;
 }
@@ -126,8 +124,8 @@ CUSTOM_CVAR( Int, r_maxparticles, 4000, CVAR_ARCHIVE )
 {
 	if ( self == 0 )
 		self = 4000;
-	else if (self > 65535)
-		self = 65535;
+	else if (self > (int)MAX_PARTICLES)
+		self = MAX_PARTICLES;
 	else if (self < 100)
 		self = 100;
 
@@ -149,7 +147,7 @@ void P_InitParticles ()
 		num = r_maxparticles;
 
 	// This should be good, but eh...
-	int NumParticles = clamp<int>(num, 100, 65535);
+	int NumParticles = clamp<int>(num, 100, MAX_PARTICLES);
 
 	Particles.Resize(NumParticles);
 	P_ClearParticles ();
@@ -157,40 +155,54 @@ void P_InitParticles ()
 
 void P_ClearParticles ()
 {
-	int i = 0;
 	memset (Particles.Data(), 0, Particles.Size() * sizeof(particle_t));
-	ActiveParticles = NO_PARTICLE;
-	InactiveParticles = 0;
-	for (auto &p : Particles)
-		p.tnext = ++i;
-	Particles.Last().tnext = NO_PARTICLE;
+	NumActiveParticles = 0;
 }
 
 // Group particles by subsectors. Because particles are always
 // in motion, there is little benefit to caching this information
 // from one frame to the next.
+//
+// This is a counting sort: count the particles per subsector, turn the
+// counts into start offsets and then drop every particle into its bin.
 
 void P_FindParticleSubsectors ()
 {
-	if (ParticlesInSubsec.Size() < level.subsectors.Size())
+	unsigned numsubsectors = level.subsectors.Size();
+	ParticlesInSubsec.Resize (numsubsectors + 1);
+	memset (ParticlesInSubsec.Data(), 0, ParticlesInSubsec.Size() * sizeof(uint32_t));
+
+	if (!r_particles || NumActiveParticles == 0)
 	{
-		ParticlesInSubsec.Reserve (level.subsectors.Size() - ParticlesInSubsec.Size());
+		return;
 	}
 
-	fillshort (&ParticlesInSubsec[0], level.subsectors.Size(), NO_PARTICLE);
+	ParticleBins.Resize (NumActiveParticles);
 
-	if (!r_particles)
+	for (uint32_t i = 0; i < NumActiveParticles; i++)
 	{
-		return;
+		particle_t *particle = &Particles[i];
+		 // Try to reuse the subsector from the last portal check, if still valid.
+		if (particle->subsector == nullptr) particle->subsector = R_PointInSubsector(particle->Pos);
+		ParticlesInSubsec[particle->subsector->Index() + 1]++;
 	}
-	for (uint16_t i = ActiveParticles; i != NO_PARTICLE; i = Particles[i].tnext)
+
+	// ParticlesInSubsec[n+1] now holds the count of subsector n. After the
+	// prefix sum it is the end of bin n, which is where bin n+1 starts.
+	for (unsigned n = 1; n <= numsubsectors; n++)
+	{
+		ParticlesInSubsec[n] += ParticlesInSubsec[n - 1];
+	}
+
+	// Fill each bin using the start of the next one as its cursor, which
+	// moves the start offsets back into place once everything is binned.
+	for (uint32_t i = 0; i < NumActiveParticles; i++)
 	{
-		 // Try to reuse the subsector from the last portal check, if still valid.
-		if (Particles[i].subsector == NULL) Particles[i].subsector = R_PointInSubsector(Particles[i].Pos);
 		int ssnum = Particles[i].subsector->Index();
-		Particles[i].snext = ParticlesInSubsec[ssnum];
-		ParticlesInSubsec[ssnum] = i;
+		ParticleBins[ParticlesInSubsec[ssnum]++] = i;
 	}
+	memmove (&ParticlesInSubsec[1], &ParticlesInSubsec[0], numsubsectors * sizeof(uint32_t));
+	ParticlesInSubsec[0] = 0;
 }
 
 static TMap<int, int> ColorSaver;
@@ -231,35 +243,43 @@ void P_InitEffects ()
 	blood2 = ParticleColor(RPART(kind)/3, GPART(kind)/3, BPART(kind)/3);
 }
 
+// Particles are updated in two passes over the packed array. The first
+// one only does the fading, scaling and lifetime bookkeeping and removes
+// expired particles by moving the last active one into their slot. The
+// second one moves the survivors, which needs the portal and BSP lookups.
+
 void P_ThinkParticles ()
 {
-	int i;
-	particle_t *particle, *prev;
+	bool frozen = bglobal.freeze || (level.flags2 & LEVEL2_FROZEN);
+	uint32_t i = 0;
 
-	i = ActiveParticles;
-	prev = NULL;
-	while (i != NO_PARTICLE)
+	while (i < NumActiveParticles)
 	{
-		particle = &Particles[i];
-		i = particle->tnext;
-		if (!particle->notimefreeze && ((bglobal.freeze) || (level.flags2 & LEVEL2_FROZEN)))
+		particle_t *particle = &Particles[i];
+		if (frozen && !particle->notimefreeze)
 		{
-			prev = particle;
+			i++;
 			continue;
 		}
-		
+
 		auto oldtrans = particle->alpha;
 		particle->alpha -= particle->fadestep;
 		particle->size += particle->sizestep;
 		if (particle->alpha <= 0 || oldtrans < particle->alpha || --particle->ttl <= 0 || (particle->size <= 0))
 		{ // The particle has expired, so free it
-			memset (particle, 0, sizeof(particle_t));
-			if (prev)
-				prev->tnext = i;
-			else
-				ActiveParticles = i;
-			particle->tnext = InactiveParticles;
-			InactiveParticles = (int)(particle - Particles.Data());
+			// The moved particle has not been updated yet, so look at this slot again.
+			*particle = Particles[--NumActiveParticles];
+			memset (&Particles[NumActiveParticles], 0, sizeof(particle_t));
+			continue;
+		}
+		i++;
+	}
+
+	for (i = 0; i < NumActiveParticles; i++)
+	{
+		particle_t *particle = &Particles[i];
+		if (frozen && !particle->notimefreeze)
+		{
 			continue;
 		}
 
@@ -288,7 +308,6 @@ void P_ThinkParticles ()
 				particle->subsector = NULL;
 			}
 		}
-		prev = particle;
 	}
 }
 
@@ -58,14 +58,17 @@ struct particle_t
 	float	fadestep;
 	float	alpha;
 	int		color;
-	uint16_t	tnext;
-	uint16_t	snext;
 };
 
+// Active particles are kept packed at the start of Particles. After
+// P_FindParticleSubsectors, the particles of subsector n are
+// Particles[ParticleBins[j]] for ParticlesInSubsec[n] <= j < ParticlesInSubsec[n+1].
 extern TArray<particle_t>	Particles;
-extern TArray<uint16_t>		ParticlesInSubsec;
+extern uint32_t				NumActiveParticles;
+extern TArray<uint32_t>		ParticlesInSubsec;
+extern TArray<uint32_t>		ParticleBins;
 
-const uint16_t NO_PARTICLE = 0xffff;
+const uint32_t MAX_PARTICLES = 1 << 20;
 
 void P_ClearParticles ();
 void P_FindParticleSubsectors ();
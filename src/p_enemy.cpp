@@ -3044,7 +3044,7 @@ int CheckBossDeath (AActor *actor)
 		return false; // no one left alive, so do not end game
 	
 	// Make sure all bosses are dead
-	TThinkerIterator<AActor> iterator;
+	FActorClassIterator iterator (actor->GetClass(), true);
 	AActor *other;
 
 	while ( (other = iterator.Next ()) )
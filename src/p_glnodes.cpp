@@ -62,6 +62,8 @@
 #include "cmdlib.h"
 #include "g_levellocals.h"
 #include "i_time.h"
+#include "c_bench.h"
+#include "m_crc32.h"
 
 CVAR(Bool, gl_cachenodes, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR(Float, gl_cachetime, 0.6f, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
@@ -874,7 +876,7 @@ bool MapLoader::LoadGLNodes(MapData * map)
 //
 //==========================================================================
 
-bool MapLoader::CheckNodes(MapData * map, bool rebuilt, int buildtime)
+bool MapLoader::CheckNodes(MapData * map, bool rebuilt)
 {
 	bool ret = false;
 	bool loaded = false;
@@ -916,24 +918,7 @@ bool MapLoader::CheckNodes(MapData * map, bool rebuilt, int buildtime)
 			builder.Extract (*Level);
 			endTime = I_msTime ();
 			DPrintf (DMSG_NOTIFY, "BSP generation took %.3f sec (%u segs)\n", (endTime - startTime) * 0.001, Level->segs.Size());
-			buildtime = (int32_t)(endTime - startTime);
-		}
-	}
-
-	if (!loaded)
-	{
-#ifdef DEBUG
-		// Building nodes in debug is much slower so let's cache them only if cachetime is 0
-		buildtime = 0;
-#endif
-		if (Level->maptype != MAPTYPE_BUILD && gl_cachenodes && buildtime/1000.f >= gl_cachetime)
-		{
-			DPrintf(DMSG_NOTIFY, "Caching nodes\n");
-			CreateCachedNodes(map);
-		}
-		else
-		{
-			DPrintf(DMSG_NOTIFY, "Not caching nodes (time = %f)\n", buildtime/1000.f);
+			RequestLevelCache(true, (int32_t)(endTime - startTime), nullptr, 0);
 		}
 	}
 	return ret;
@@ -947,6 +932,35 @@ bool MapLoader::CheckNodes(MapData * map, bool rebuilt, int buildtime)
 
 typedef TArray<uint8_t> MemFile;
 
+//==========================================================================
+//
+// Level preprocessing cache
+//
+// Stores the output of the node builder and the blockmap generator so that
+// repeated loads of the same map can skip both. A cache file is keyed by
+// the map's MD5 and line count and contains a table of sections, each of
+// which is checked against its own CRC before being used:
+//
+//   VRTX  vertex indices of every line after node building
+//   NODE  node data, ZGL3 for GL nodes or ZNO3 for regular nodes
+//   OVTX  original vertex index to new vertex index, for vertex heights
+//   BMAP  generated blockmap as little-endian ints, loaded without parsing
+//
+//==========================================================================
+
+enum
+{
+	LEVELCACHE_VERSION = 1,
+	LEVELCACHE_MAXSECTIONS = 8,
+};
+
+struct FLevelCacheSection
+{
+	uint32_t id;
+	uint32_t offset;
+	uint32_t length;
+	uint32_t crc;
+};
 
 static FString CreateCacheName(MapData *map, bool create)
 {
@@ -983,8 +997,116 @@ static void WriteLong(MemFile &f, uint32_t b)
 	f[v+3] = (uint8_t)(b>>24);
 }
 
-void MapLoader::CreateCachedNodes(MapData *map)
+static void WriteSection(MemFile &f, TArray<FLevelCacheSection> &sections, uint32_t id, const MemFile &data)
+{
+	FLevelCacheSection &section = sections[sections.Reserve(1)];
+	section.id = id;
+	section.offset = f.Size();
+	section.length = data.Size();
+	section.crc = data.Size() > 0 ? CalcCRC32(data.Data(), data.Size()) : 0;
+	f.Append(data);
+}
+
+//==========================================================================
+//
+// Opens a cache file and validates its header against the current map
+//
+//==========================================================================
+
+static bool OpenLevelCache(MapData *map, unsigned numlines, FileReader &fr, TArray<FLevelCacheSection> &sections)
+{
+	char magic[4];
+	uint8_t md5[16];
+	uint8_t md5map[16];
+
+	FString path = CreateCacheName(map, false);
+	if (!fr.OpenMappedFile(path)) return false;
+
+	if (fr.Read(magic, 4) != 4 || memcmp(magic, "LVLC", 4)) return false;
+	if (fr.ReadUInt32() != LEVELCACHE_VERSION) return false;
+	if (fr.ReadUInt32() != numlines) return false;
+
+	if (fr.Read(md5, 16) != 16) return false;
+	map->GetChecksum(md5map);
+	if (memcmp(md5, md5map, 16)) return false;
+
+	uint32_t numsections = fr.ReadUInt32();
+	if (numsections > LEVELCACHE_MAXSECTIONS) return false;
+
+	auto filesize = fr.GetLength();
+	sections.Resize(numsections);
+	for (auto &section : sections)
+	{
+		section.id = fr.ReadUInt32();
+		section.offset = fr.ReadUInt32();
+		section.length = fr.ReadUInt32();
+		section.crc = fr.ReadUInt32();
+		if ((int64_t)section.offset + section.length > filesize) return false;
+	}
+	return true;
+}
+
+static const FLevelCacheSection *FindSection(const TArray<FLevelCacheSection> &sections, uint32_t id)
+{
+	for (auto &section : sections)
+	{
+		if (section.id == id) return &section;
+	}
+	return nullptr;
+}
+
+// Reads a section into the given buffer, which must be section->length bytes.
+static bool ReadSection(FileReader &fr, const FLevelCacheSection *section, void *buffer)
+{
+	fr.Seek(section->offset, FileReader::SeekSet);
+	if (fr.Read(buffer, section->length) != section->length) return false;
+	return CalcCRC32((const uint8_t *)buffer, section->length) == section->crc;
+}
+
+static bool ReadSection(FileReader &fr, const TArray<FLevelCacheSection> &sections, uint32_t id, TArray<uint8_t> &data)
 {
+	auto section = FindSection(sections, id);
+	if (section == nullptr) return false;
+	data.Resize(section->length);
+	return section->length == 0 || ReadSection(fr, section, data.Data());
+}
+
+//==========================================================================
+//
+// Remembers what should go into the cache once the level is set up.
+// The file is written by WriteLevelCache after the blockmap is known.
+//
+//==========================================================================
+
+void MapLoader::RequestLevelCache(bool glnodes, int buildtime, const int *oldvertextable, unsigned numoldverts)
+{
+#ifdef DEBUG
+	// Building nodes in debug is much slower so let's cache them only if cachetime is 0
+	buildtime = 0;
+#endif
+	if (Level->maptype != MAPTYPE_BUILD && gl_cachenodes && buildtime/1000.f >= gl_cachetime)
+	{
+		DPrintf(DMSG_NOTIFY, "Caching nodes\n");
+		CacheLevel = true;
+		CacheGLNodes = glnodes;
+		CacheVertexTable.Clear();
+		if (oldvertextable != nullptr)
+		{
+			CacheVertexTable.Resize(numoldverts);
+			memcpy(CacheVertexTable.Data(), oldvertextable, numoldverts * sizeof(int));
+		}
+	}
+	else
+	{
+		DPrintf(DMSG_NOTIFY, "Not caching nodes (time = %f)\n", buildtime/1000.f);
+	}
+}
+
+void MapLoader::WriteLevelCache(MapData *map)
+{
+	if (!CacheLevel) return;
+	CacheLevel = false;
+
 	MemFile ZNodes;
 
 	WriteLong(ZNodes, 0);
@@ -1005,7 +1127,15 @@ void MapLoader::CreateCachedNodes(MapData *map)
 	for(auto &seg : Level->segs)
 	{
 		WriteLong(ZNodes, seg.v1->Index());
-		WriteLong(ZNodes, seg.PartnerSeg == nullptr? 0xffffffffu : uint32_t(seg.PartnerSeg->Index()));
+		if (CacheGLNodes)
+		{
+			WriteLong(ZNodes, seg.PartnerSeg == nullptr? 0xffffffffu : uint32_t(seg.PartnerSeg->Index()));
+		}
+		else
+		{
+			// Regular nodes have no closed subsectors so the end vertex is needed.
+			WriteLong(ZNodes, seg.v2->Index());
+		}
 		if (seg.linedef)
 		{
 			WriteLong(ZNodes, uint32_t(seg.linedef->Index()));
@@ -1049,38 +1179,70 @@ void MapLoader::CreateCachedNodes(MapData *map)
 	}
 
 	uLongf outlen = ZNodes.Size();
-	TArray<Bytef> compressed;
-	int offset = Level->lines.Size() * 8 + 12 + 16;
+	MemFile compressed;
 	int r;
 	do
 	{
-		compressed.Resize(outlen + offset);
-		r = compress (compressed.Data() + offset, &outlen, &ZNodes[0], ZNodes.Size());
+		compressed.Resize(outlen + 4);
+		r = compress (compressed.Data() + 4, &outlen, &ZNodes[0], ZNodes.Size());
 		if (r == Z_BUF_ERROR)
 		{
 			outlen += 1024;
 		}
 	} 
 	while (r == Z_BUF_ERROR);
+	compressed.Resize(outlen + 4);
+	memcpy(compressed.Data(), CacheGLNodes ? "ZGL3" : "ZNO3", 4);
+
+	MemFile verts;
+	for (auto &line : Level->lines)
+	{
+		WriteLong(verts, uint32_t(line.v1->Index()));
+		WriteLong(verts, uint32_t(line.v2->Index()));
+	}
+
+	MemFile oldverts;
+	for (auto v : CacheVertexTable)
+	{
+		WriteLong(oldverts, uint32_t(v));
+	}
+
+	MemFile blockmap;
+	for (unsigned i = 0; i < GeneratedBlockmapSize; i++)
+	{
+		WriteLong(blockmap, uint32_t(Level->blockmap.blockmaplump[i]));
+	}
 
-	memcpy(compressed.Data(), "CACH", 4);
-	uint32_t len = LittleLong(Level->lines.Size());
-	memcpy(&compressed[4], &len, 4);
-	map->GetChecksum(&compressed[8]);
-	for (unsigned i = 0; i < Level->lines.Size(); i++)
+	MemFile body;
+	TArray<FLevelCacheSection> sections;
+	WriteSection(body, sections, MAKE_ID('V','R','T','X'), verts);
+	WriteSection(body, sections, MAKE_ID('N','O','D','E'), compressed);
+	if (oldverts.Size() > 0) WriteSection(body, sections, MAKE_ID('O','V','T','X'), oldverts);
+	if (blockmap.Size() > 0) WriteSection(body, sections, MAKE_ID('B','M','A','P'), blockmap);
+
+	MemFile header;
+	for (auto c : { 'L', 'V', 'L', 'C' }) WriteByte(header, c);
+	WriteLong(header, LEVELCACHE_VERSION);
+	WriteLong(header, Level->lines.Size());
+	header.Reserve(16);
+	map->GetChecksum(&header[header.Size() - 16]);
+	WriteLong(header, sections.Size());
+	uint32_t bodystart = header.Size() + sections.Size() * sizeof(FLevelCacheSection);
+	for (auto &section : sections)
 	{
-		uint32_t ndx[2] = { LittleLong(uint32_t(Level->lines[i].v1->Index())), LittleLong(uint32_t(Level->lines[i].v2->Index())) };
-		memcpy(&compressed[8 + 16 + 8 * i], ndx, 8);
+		WriteLong(header, section.id);
+		WriteLong(header, section.offset + bodystart);
+		WriteLong(header, section.length);
+		WriteLong(header, section.crc);
 	}
-	memcpy(&compressed[offset - 4], "ZGL3", 4);
 
 	FString path = CreateCacheName(map, true);
 	FileWriter *fw = FileWriter::Open(path);
 
 	if (fw != nullptr)
 	{
-		const size_t length = outlen + offset;
-		if (fw->Write(compressed.Data(), length) != length)
+		if (fw->Write(header.Data(), header.Size()) != header.Size() ||
+			fw->Write(body.Data(), body.Size()) != body.Size())
 		{
 			Printf("Error saving nodes to file %s\n", path.GetChars());
 		}
@@ -1092,41 +1254,42 @@ void MapLoader::CreateCachedNodes(MapData *map)
 	}
 }
 
+//==========================================================================
+//
+// Loads nodes from the level cache. Regular nodes are only accepted if
+// the caller does not need GL nodes.
+//
+//==========================================================================
 
-bool MapLoader::CheckCachedNodes(MapData *map)
+bool MapLoader::CheckCachedNodes(MapData *map, bool requireGL)
 {
-	char magic[4] = {0,0,0,0};
-	uint8_t md5[16];
-	uint8_t md5map[16];
-	uint32_t numlin;
-	TArray<uint32_t> verts;
-
-	FString path = CreateCacheName(map, false);
+	TArray<FLevelCacheSection> sections;
+	TArray<uint8_t> verts, nodes, oldverts;
 	FileReader fr;
+	unsigned numlin = Level->lines.Size();
 
-	if (!fr.OpenFile(path)) return false;
+	if (!OpenLevelCache(map, numlin, fr, sections)) return false;
 
-	if (fr.Read(magic, 4) != 4) return false;
-	if (memcmp(magic, "CACH", 4))  return false;
+	if (!ReadSection(fr, sections, MAKE_ID('V','R','T','X'), verts) || verts.Size() != numlin * 8) return false;
+	if (!ReadSection(fr, sections, MAKE_ID('N','O','D','E'), nodes) || nodes.Size() < 4) return false;
 
-	if (fr.Read(&numlin, 4) != 4) return false; 
-	numlin = LittleLong(numlin);
-	if (numlin != Level->lines.Size()) return false;
-
-	if (fr.Read(md5, 16) != 16) return false;
-	map->GetChecksum(md5map);
-	if (memcmp(md5, md5map, 16)) return false;
-
-	verts.Resize(numlin * 2);
-	if (fr.Read(verts.Data(), 8 * numlin) != 8 * numlin) return false;
-
-	if (fr.Read(magic, 4) != 4) return false;
-	if (memcmp(magic, "ZGL2", 4) && memcmp(magic, "ZGL3", 4))  return false;
+	uint32_t id = MAKE_ID(nodes[0], nodes[1], nodes[2], nodes[3]);
+	if (id != MAKE_ID('Z','G','L','3') && (requireGL || id != MAKE_ID('Z','N','O','3'))) return false;
 
+	if (ReadSection(fr, sections, MAKE_ID('O','V','T','X'), oldverts))
+	{
+		CachedVertexTable.Resize(oldverts.Size() / 4);
+		for (unsigned i = 0; i < CachedVertexTable.Size(); i++)
+		{
+			CachedVertexTable[i] = GetInt(&oldverts[i * 4]);
+		}
+	}
 
+	FileReader nodereader;
+	nodereader.OpenMemory(&nodes[4], nodes.Size() - 4);
 	try
 	{
-		LoadExtendedNodes (fr, MAKE_ID(magic[0],magic[1],magic[2],magic[3]));
+		LoadExtendedNodes (nodereader, id);
 	}
 	catch (CRecoverableError &error)
 	{
@@ -1135,18 +1298,77 @@ bool MapLoader::CheckCachedNodes(MapData *map)
 		Level->subsectors.Clear();
 		Level->segs.Clear();
 		Level->nodes.Clear();
+		CachedVertexTable.Clear();
 		return false;
 	}
 
 	for(auto &line : Level->lines)
 	{
 		int i = line.Index();
-		line.v1 = &Level->vertexes[LittleLong(verts[i*2])];
-		line.v2 = &Level->vertexes[LittleLong(verts[i*2+1])];
+		line.v1 = &Level->vertexes[GetInt(&verts[i*8])];
+		line.v2 = &Level->vertexes[GetInt(&verts[i*8+4])];
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Hands the vertex table of cached nodes over to the caller, who takes
+// ownership the same way as with FNodeBuilder::GetOldVertexTable.
+//
+//==========================================================================
+
+const int *MapLoader::GetCachedVertexTable()
+{
+	if (CachedVertexTable.Size() == 0) return nullptr;
+	int *table = new int[CachedVertexTable.Size()];
+	memcpy(table, CachedVertexTable.Data(), CachedVertexTable.Size() * sizeof(int));
+	CachedVertexTable.Clear();
+	return table;
+}
+
+//==========================================================================
+//
+// Loads a previously generated blockmap straight into the level.
+// The data is stored exactly as FBlockmap keeps it in memory.
+//
+//==========================================================================
+
+bool MapLoader::CheckCachedBlockmap(MapData *map)
+{
+	TArray<FLevelCacheSection> sections;
+	FileReader fr;
+
+	if (!OpenLevelCache(map, Level->lines.Size(), fr, sections)) return false;
+
+	auto section = FindSection(sections, MAKE_ID('B','M','A','P'));
+	if (section == nullptr || section->length < 16 || (section->length & 3)) return false;
+
+	unsigned count = section->length / 4;
+	int *blockmaplump = new int[count];
+	if (!ReadSection(fr, section, blockmaplump))
+	{
+		delete[] blockmaplump;
+		return false;
+	}
+#ifdef __BIG_ENDIAN__
+	for (unsigned i = 0; i < count; i++)
+	{
+		blockmaplump[i] = LittleLong(blockmaplump[i]);
+	}
+#endif
+	Level->blockmap.blockmaplump = blockmaplump;
+	GeneratedBlockmapSize = count;
+	if (!Level->blockmap.VerifyBlockMap(count, Level->lines.Size()))
+	{
+		delete[] blockmaplump;
+		Level->blockmap.blockmaplump = nullptr;
+		return false;
 	}
 	return true;
 }
 
+
 UNSAFE_CCMD(clearnodecache)
 {
 	TArray<FFileList> list;
@@ -1180,6 +1402,58 @@ UNSAFE_CCMD(clearnodecache)
 		
 }
 
+//==========================================================================
+//
+// benchnodes [count]
+//
+// Rebuilds the current level's GL nodes with the serial and the parallel
+// splitter evaluation, prints the timings and checks that both produced
+// the same tree. The level itself is not touched.
+//
+//==========================================================================
+
+EXTERN_CVAR(Bool, nb_parallel)
+
+CCMD(benchnodes)
+{
+	if (gamestate != GS_LEVEL || level.lines.Size() == 0)
+	{
+		Printf("benchnodes can only be used in a level\n");
+		return;
+	}
+
+	int count = C_BenchCount(argv, 1, 1);
+	bool saved = nb_parallel;
+
+	TArray<FNodeBuilder::FPolyStart> polyspots, anchors;
+	FNodeBuilder::FLevel leveldata =
+	{
+		&level.vertexes[0], (int)level.vertexes.Size(),
+		&level.sides[0], (int)level.sides.Size(),
+		&level.lines[0], (int)level.lines.Size(),
+		0, 0, 0, 0
+	};
+	leveldata.FindMapBounds();
+
+	auto build = [&](bool parallel)
+	{
+		nb_parallel = parallel;
+		return C_BenchTime(count, [&](int) { FNodeBuilder builder(leveldata, polyspots, anchors, true); });
+	};
+	uint64_t serialtime = build(false);
+	uint64_t paralleltime = build(true);
+
+	nb_parallel = false;
+	FNodeBuilder serial(leveldata, polyspots, anchors, true);
+	nb_parallel = true;
+	FNodeBuilder parallel(leveldata, polyspots, anchors, true);
+	nb_parallel = saved;
+
+	Printf("Serial:   %.3f ms\n", serialtime * 1e-6 / count);
+	Printf("Parallel: %.3f ms %s\n", paralleltime * 1e-6 / count, C_BenchSpeedup(serialtime, paralleltime).GetChars());
+	C_BenchCheck(!serial.SameTree(parallel), "Trees differ!");
+}
+
 //==========================================================================
 //
 // Keep both the original nodes from the WAD and the GL nodes created here.
@@ -6646,23 +6646,14 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 			// no thing checks for attached sectors because of heightsec
 			if (sec->heightsec == sector) continue;
 
-			for (n = sec->touching_thinglist; n; n = n->m_snext) n->visited = false;
-			do
+			P_ScanSectorThings(sec, [&](AActor *thing)
 			{
-				for (n = sec->touching_thinglist; n; n = n->m_snext)
+				if (!(thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
+					(thing->flags5 & MF5_MOVEWITHSECTOR))
 				{
-					if (!n->visited)
-					{
-						n->visited = true;
-						if (!(n->m_thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
-							(n->m_thing->flags5 & MF5_MOVEWITHSECTOR))
-						{
-							iterator(n->m_thing, &cpos);
-						}
-						break;
-					}
+					iterator(thing, &cpos);
 				}
-			} while (n);
+			});
 			sec->CheckPortalPlane(!floorOrCeil);
 		}
 	}
@@ -6703,29 +6694,18 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 	// Things can arbitrarily be inserted and removed and it won't mess up.
 	//
 	// killough 4/7/98: simplified to avoid using complicated counter
+	//
+	// P_ScanSectorThings only skips the rescans that cannot find anything new.
 
-	// Mark all things invalid
-
-	for (n = sector->touching_thinglist; n; n = n->m_snext)
-		n->visited = false;
-
-	do
+	P_ScanSectorThings(sector, [&](AActor *thing)
 	{
-		for (n = sector->touching_thinglist; n; n = n->m_snext)	// go through list
+		if (!(thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
+			(thing->flags5 & MF5_MOVEWITHSECTOR))
 		{
-			if (!n->visited)								// unprocessed thing found
-			{
-				n->visited = true; 							// mark thing as processed
-				if (!(n->m_thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
-					(n->m_thing->flags5 & MF5_MOVEWITHSECTOR))
-				{
-					iterator(n->m_thing, &cpos);		 			// process it
-					if (iterator2 != NULL) iterator2(n->m_thing, &cpos);
-				}
-				break;										// exit and start over
-			}
+			iterator(thing, &cpos);		 			// process it
+			if (iterator2 != NULL) iterator2(thing, &cpos);
 		}
-	} while (n);	// repeat from scratch until all things left are marked valid
+	});
 
 	if (floorOrCeil != 2) sector->CheckPortalPlane(floorOrCeil);	// check for portal obstructions after everything is done.
 
@@ -6742,6 +6722,7 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 
 			for (n = s->touching_thinglist; n; n = n->m_snext)
 				n->visited = false;
+			secnodegeneration++;	// see P_ScanSectorThings
 
 			do
 			{
@@ -61,6 +61,7 @@
 
 
 #include <stdlib.h>
+#include <algorithm>
 
 
 #include "m_bbox.h"
@@ -75,10 +76,12 @@
 #include "r_utility.h"
 #include "actor.h"
 #include "actorinlines.h"
+#include "d_player.h"
 
 // State.
 #include "po_man.h"
 #include "vm.h"
+#include "memarena.h"
 
 sector_t *P_PointInSectorBuggy(double x, double y);
 int P_VanillaPointOnDivlineSide(double x, double y, const divline_t* line);
@@ -335,6 +338,7 @@ void AActor::UnlinkFromWorld (FLinkContext *ctx)
 				block->NextActor->PrevActor = block->PrevActor;
 			}
 			*(block->PrevActor) = block->NextActor;
+			level.blockmap.superblockcounts[level.blockmap.GetSuperBlock(block->BlockIndex)]--;
 			FBlockNode *next = block->NextBlock;
 			block->Release ();
 			block = next;
@@ -539,6 +543,7 @@ void AActor::LinkToWorld(FLinkContext *ctx, bool spawningmapthing, sector_t *sec
 						}
 						node->PrevActor = link;
 						*link = node;
+						level.blockmap.superblockcounts[level.blockmap.GetSuperBlock(x, y)]++;
 
 						// Link in to actor
 						node->PrevBlock = alink;
@@ -572,6 +577,11 @@ void AActor::SetOrigin(double x, double y, double z, bool moving)
 
 FBlockNode *FBlockNode::FreeBlocks = NULL;
 
+// Nodes are carved out of large blocks instead of being allocated one by one.
+// Released nodes go to the free list and are reused from there, so the arena
+// only grows to the peak number of links and is not emptied between levels.
+FMemArena blocknodearena(64 * 1024);
+
 FBlockNode *FBlockNode::Create (AActor *who, int x, int y, int group)
 {
 	FBlockNode *block;
@@ -583,7 +593,7 @@ FBlockNode *FBlockNode::Create (AActor *who, int x, int y, int group)
 	}
 	else
 	{
-		block = new FBlockNode;
+		block = (FBlockNode *)blocknodearena.Alloc(sizeof(FBlockNode));
 	}
 	block->BlockIndex = x + y*level.blockmap.bmapwidth;
 	block->Me = who;
@@ -1180,6 +1190,248 @@ void FMultiBlockThingsIterator::Reset()
 	startIteratorForGroup(basegroup);
 }
 
+//===========================================================================
+//
+// FThingQuery :: Matches
+//
+//===========================================================================
+
+bool FThingQuery::Matches(AActor *thing) const
+{
+	if (thing == Exclude) return false;
+	if (TID != 0 && thing->tid != TID) return false;
+	if ((Flags & TQF_SHOOTABLE) && !(thing->flags & MF_SHOOTABLE)) return false;
+	if ((Flags & TQF_SOLID) && !(thing->flags & MF_SOLID)) return false;
+	if ((Flags & TQF_ALIVE) && thing->health <= 0) return false;
+	if ((Flags & TQF_MONSTERS) && !(thing->flags3 & MF3_ISMONSTER)) return false;
+	if ((Flags & TQF_PLAYERS) && (thing->player == nullptr || thing->player->mo != thing)) return false;
+	return Type == nullptr || thing->IsKindOf(Type);
+}
+
+//===========================================================================
+//
+// FThingQuery :: IsFirstVisit
+//
+// A thing is linked into every block it touches, but it only gets reported
+// from the block its center is in. Everything that can match a query has
+// its center within the query's blocks, so nothing is missed and no hash of
+// the things seen so far is needed.
+//
+//===========================================================================
+
+bool FThingQuery::IsFirstVisit(FBlockNode *node)
+{
+	AActor *thing = node->Me;
+	int x = clamp(level.blockmap.GetBlockX(thing->X()), 0, level.blockmap.bmapwidth - 1);
+	int y = clamp(level.blockmap.GetBlockY(thing->Y()), 0, level.blockmap.bmapheight - 1);
+	int center = y * level.blockmap.bmapwidth + x;
+
+	for (FBlockNode *block = thing->BlockNode; block != nullptr; block = block->NextBlock)
+	{
+		if (block->BlockIndex == center)
+		{
+			return block == node;
+		}
+	}
+	// The thing was moved without being relinked, so just take its first link.
+	return node == thing->BlockNode;
+}
+
+//===========================================================================
+//
+// FThingQuery :: ForEachThing
+//
+// Calls func for every thing reported by the blocks in the given range.
+//
+//===========================================================================
+
+template<class Func>
+void FThingQuery::ForEachThing(int x1, int y1, int x2, int y2, Func func)
+{
+	auto &bm = level.blockmap;
+	x1 = MAX(x1, 0);
+	y1 = MAX(y1, 0);
+	x2 = MIN(x2, bm.bmapwidth - 1);
+	y2 = MIN(y2, bm.bmapheight - 1);
+
+	for (int sy = y1 >> FBlockmap::SUPERBLOCKSHIFT; sy <= y2 >> FBlockmap::SUPERBLOCKSHIFT; sy++)
+	{
+		for (int sx = x1 >> FBlockmap::SUPERBLOCKSHIFT; sx <= x2 >> FBlockmap::SUPERBLOCKSHIFT; sx++)
+		{
+			if (bm.superblockcounts[sy * bm.superwidth + sx] == 0)
+			{
+				continue;
+			}
+			int bx1 = MAX(x1, sx << FBlockmap::SUPERBLOCKSHIFT);
+			int by1 = MAX(y1, sy << FBlockmap::SUPERBLOCKSHIFT);
+			int bx2 = MIN(x2, ((sx + 1) << FBlockmap::SUPERBLOCKSHIFT) - 1);
+			int by2 = MIN(y2, ((sy + 1) << FBlockmap::SUPERBLOCKSHIFT) - 1);
+			for (int y = by1; y <= by2; y++)
+			{
+				for (int x = bx1; x <= bx2; x++)
+				{
+					for (FBlockNode *node = bm.blocklinks[y * bm.bmapwidth + x]; node != nullptr; node = node->NextActor)
+					{
+						if (IsFirstVisit(node))
+						{
+							func(node->Me);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+//===========================================================================
+//
+// FThingQuery :: Output
+//
+//===========================================================================
+
+void FThingQuery::Output(TArray<Candidate> &candidates, TArray<AActor *> &results)
+{
+	if (Flags & TQF_SORT)
+	{
+		std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) { return a.distsq < b.distsq; });
+	}
+	results.Resize(candidates.Size());
+	for (unsigned i = 0; i < candidates.Size(); i++)
+	{
+		results[i] = candidates[i].thing;
+	}
+}
+
+//===========================================================================
+//
+// FThingQuery :: InRadius
+//
+//===========================================================================
+
+void FThingQuery::InRadius(const DVector3 &pos, double radius, TArray<AActor *> &results)
+{
+	TArray<Candidate> candidates;
+	results.Clear();
+	if (level.blockmap.blocklinks == nullptr || radius < 0)
+	{
+		return;
+	}
+
+	double radiussq = radius * radius;
+	ForEachThing(level.blockmap.GetBlockX(pos.X - radius), level.blockmap.GetBlockY(pos.Y - radius),
+		level.blockmap.GetBlockX(pos.X + radius), level.blockmap.GetBlockY(pos.Y + radius), [&](AActor *thing)
+	{
+		double distsq = (thing->Pos() - pos).LengthSquared();
+		if (distsq <= radiussq && Matches(thing))
+		{
+			candidates.Push({ thing, distsq });
+		}
+	});
+	Output(candidates, results);
+}
+
+//===========================================================================
+//
+// FThingQuery :: InBox
+//
+// With TQF_SORT the results are sorted by their distance to the box center.
+//
+//===========================================================================
+
+void FThingQuery::InBox(const DVector3 &mins, const DVector3 &maxs, TArray<AActor *> &results)
+{
+	TArray<Candidate> candidates;
+	results.Clear();
+	if (level.blockmap.blocklinks == nullptr)
+	{
+		return;
+	}
+
+	DVector3 center = (mins + maxs) / 2;
+	ForEachThing(level.blockmap.GetBlockX(mins.X), level.blockmap.GetBlockY(mins.Y),
+		level.blockmap.GetBlockX(maxs.X), level.blockmap.GetBlockY(maxs.Y), [&](AActor *thing)
+	{
+		DVector3 p = thing->Pos();
+		if (p.X >= mins.X && p.X <= maxs.X && p.Y >= mins.Y && p.Y <= maxs.Y && p.Z >= mins.Z && p.Z <= maxs.Z && Matches(thing))
+		{
+			candidates.Push({ thing, (p - center).LengthSquared() });
+		}
+	});
+	Output(candidates, results);
+}
+
+//===========================================================================
+//
+// FThingQuery :: Nearest
+//
+// Searches rings of superblocks around the point and stops once the next
+// ring is farther away than the count'th nearest match found so far, or
+// than maxdist if that is positive. The results are always sorted.
+//
+//===========================================================================
+
+void FThingQuery::Nearest(const DVector3 &pos, int count, double maxdist, TArray<AActor *> &results)
+{
+	TArray<Candidate> heap;
+	results.Clear();
+	if (level.blockmap.blocklinks == nullptr || count <= 0)
+	{
+		return;
+	}
+
+	auto &bm = level.blockmap;
+	auto further = [](const Candidate &a, const Candidate &b) { return a.distsq < b.distsq; };
+	const double ringsize = FBlockmap::MAPBLOCKUNITS * FBlockmap::SUPERBLOCKSIZE;
+	double maxdistsq = maxdist > 0 ? maxdist * maxdist : DBL_MAX;
+	int px = clamp(bm.GetBlockX(pos.X), 0, bm.bmapwidth - 1) >> FBlockmap::SUPERBLOCKSHIFT;
+	int py = clamp(bm.GetBlockY(pos.Y), 0, bm.bmapheight - 1) >> FBlockmap::SUPERBLOCKSHIFT;
+	int maxring = MAX(MAX(px, bm.superwidth - 1 - px), MAX(py, bm.superheight - 1 - py));
+
+	auto check = [&](AActor *thing)
+	{
+		double distsq = (thing->Pos() - pos).LengthSquared();
+		if (distsq > maxdistsq || ((int)heap.Size() == count && distsq >= heap[0].distsq) || !Matches(thing))
+		{
+			return;
+		}
+		if ((int)heap.Size() == count)
+		{
+			std::pop_heap(heap.begin(), heap.end(), further);
+			heap.Pop();
+		}
+		heap.Push({ thing, distsq });
+		std::push_heap(heap.begin(), heap.end(), further);
+	};
+
+	for (int ring = 0; ring <= maxring; ring++)
+	{
+		for (int sy = py - ring; sy <= py + ring; sy++)
+		{
+			if (sy < 0 || sy >= bm.superheight) continue;
+			// only the left and right edges of the ring except on its top and bottom rows
+			int step = (sy == py - ring || sy == py + ring) ? 1 : MAX(2 * ring, 1);
+			for (int sx = px - ring; sx <= px + ring; sx += step)
+			{
+				if (sx < 0 || sx >= bm.superwidth) continue;
+				ForEachThing(sx << FBlockmap::SUPERBLOCKSHIFT, sy << FBlockmap::SUPERBLOCKSHIFT,
+					((sx + 1) << FBlockmap::SUPERBLOCKSHIFT) - 1, ((sy + 1) << FBlockmap::SUPERBLOCKSHIFT) - 1, check);
+			}
+		}
+		// Everything not found yet is at least this far away.
+		double nextdist = ring * ringsize;
+		if (nextdist * nextdist > maxdistsq || ((int)heap.Size() == count && nextdist * nextdist >= heap[0].distsq))
+		{
+			break;
+		}
+	}
+	std::sort_heap(heap.begin(), heap.end(), further);
+	results.Resize(heap.Size());
+	for (unsigned i = 0; i < heap.Size(); i++)
+	{
+		results[i] = heap[i].thing;
+	}
+}
+
 //===========================================================================
 //
 // FPathTraverse :: Intercepts
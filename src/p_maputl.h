@@ -126,6 +126,49 @@ inline void P_LineOpening(FLineOpening &open, AActor *thing, const line_t *lined
 class FBoundingBox;
 struct polyblock_t;
 
+//============================================================================
+//
+// P_ScanSectorThings
+//
+// killough's scan of a sector's touching_thinglist: the list is searched
+// from the head for the first unvisited node after each thing is processed,
+// so that things can be linked and unlinked by the processing without
+// breaking anything.
+//
+// Every change to a sector thread, and every reset of the visited flags,
+// bumps secnodegeneration. As long as that stays the same, the processed
+// node is still linked and all nodes before it are still marked, so the
+// search can go on from there instead of walking the visited part of the
+// list again. The order things are processed in is exactly the same.
+//
+//============================================================================
+
+extern unsigned secnodegeneration;
+
+template<class Func>
+void P_ScanSectorThings(sector_t *sector, Func process)
+{
+	msecnode_t *n;
+
+	for (n = sector->touching_thinglist; n; n = n->m_snext)
+		n->visited = false;
+	secnodegeneration++;	// restarts any scan of this list further up the stack
+
+	n = sector->touching_thinglist;
+	while (n != nullptr)
+	{
+		if (n->visited)
+		{
+			n = n->m_snext;
+			continue;
+		}
+		n->visited = true;
+		unsigned generation = secnodegeneration;
+		process(n->m_thing);
+		n = generation == secnodegeneration ? n->m_snext : sector->touching_thinglist;
+	}
+}
+
 //============================================================================
 //
 // This is a dynamic array which holds its first MAX_STATIC entries in normal
@@ -351,6 +394,55 @@ public:
 	}
 };
 
+//============================================================================
+//
+// FThingQuery
+//
+// Collects the things whose center lies in a radius or box, or the ones
+// nearest to a point, in one go. Superblocks without any things in them
+// are skipped without looking at their blocks. Portals are not crossed.
+//
+//============================================================================
+
+enum EThingQueryFlags
+{
+	TQF_SHOOTABLE = 1,		// only things with MF_SHOOTABLE
+	TQF_ALIVE = 2,			// only things with health > 0
+	TQF_MONSTERS = 4,		// only things with MF3_ISMONSTER
+	TQF_PLAYERS = 8,		// only player controlled things
+	TQF_SOLID = 16,			// only things with MF_SOLID
+	TQF_SORT = 32,			// sort the results by distance, nearest first
+};
+
+class FThingQuery
+{
+	struct Candidate
+	{
+		AActor *thing;
+		double distsq;
+	};
+
+	static bool IsFirstVisit(FBlockNode *node);
+	template<class Func> void ForEachThing(int x1, int y1, int x2, int y2, Func func);
+	void Output(TArray<Candidate> &candidates, TArray<AActor *> &results);
+
+public:
+	PClassActor *Type;
+	int TID;
+	int Flags;
+	AActor *Exclude;
+
+	FThingQuery(PClassActor *type = nullptr, int tid = 0, int flags = 0, AActor *exclude = nullptr)
+		: Type(type), TID(tid), Flags(flags), Exclude(exclude)
+	{
+	}
+
+	bool Matches(AActor *thing) const;
+	void InRadius(const DVector3 &pos, double radius, TArray<AActor *> &results);
+	void InBox(const DVector3 &mins, const DVector3 &maxs, TArray<AActor *> &results);
+	void Nearest(const DVector3 &pos, int count, double maxdist, TArray<AActor *> &results);
+};
+
 
 
 class FPathTraverse
@@ -60,6 +60,7 @@
 #include <float.h>
 #include "templates.h"
 #include "i_system.h"
+#include "i_time.h"
 #include "m_random.h"
 #include "doomdef.h"
 #include "p_local.h"
@@ -99,6 +100,7 @@
 #include "actorinlines.h"
 #include "a_dynlight.h"
 #include "fragglescript/t_fs.h"
+#include "c_bench.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -177,6 +179,7 @@ AActor::~AActor ()
 {
 	// Please avoid calling the destructor directly (or through delete)!
 	// Use Destroy() instead.
+	InvalidateInventoryIndex();
 }
 
 
@@ -607,6 +610,7 @@ DEFINE_ACTION_FUNCTION(AActor, SetState)
 void AActor::DestroyAllInventory ()
 {
 	AActor *inv = Inventory;
+	InvalidateInventoryIndex();
 	if (inv != nullptr)
 	{
 		TArray<AActor *> toDelete;
@@ -683,6 +687,94 @@ AActor *AActor::DropInventory (AActor *item, int amt)
 	return nullptr;
 }
 
+//============================================================================
+//
+// FInventoryIndex
+//
+// Once FindInventory has to walk past INVINDEX_MINITEMS items the actor
+// gets a lookup table: the first item of each class in the chain and the
+// results of all subclass searches made so far. AddInventory and
+// RemoveInventory throw it away. Any other code that changes the Inventory
+// links has to call InvalidateInventoryIndex, the table cannot tell that
+// the chain was changed behind its back. As a cheap sanity check a cached
+// item is not returned any more once it was destroyed, given to another
+// actor, or the chain starts with a different item.
+//
+//============================================================================
+
+enum { INVINDEX_MINITEMS = 16 };
+
+struct FInventoryIndex
+{
+	AActor *Head;
+	TArray<AActor *> Items;
+	TMap<PClass *, int> Exact;
+	TMap<PClass *, int> Kinds;	// failed searches are stored as -1
+	PField *OwnerField;
+
+	FInventoryIndex(AActor *head)
+	{
+		Head = head;
+		for (AActor *item = head; item != nullptr; item = item->Inventory)
+		{
+			if (Exact.CheckKey(item->GetClass()) == nullptr)
+			{
+				Exact[item->GetClass()] = Items.Size();
+			}
+			Items.Push(item);
+		}
+		OwnerField = dyn_cast<PField>(PClass::FindClass(NAME_Inventory)->FindSymbol(NAME_Owner, true));
+	}
+
+	// Returns the position of the item in Items, or -1 if there is none.
+	int Find(PClassActor *type, bool subclass)
+	{
+		int *found = subclass ? Kinds.CheckKey(type) : Exact.CheckKey(type);
+		if (found != nullptr || !subclass)
+		{
+			return found != nullptr ? *found : -1;
+		}
+		int index = -1;
+		for (unsigned i = 0; i < Items.Size(); i++)
+		{
+			if (Items[i]->IsKindOf(type))
+			{
+				index = i;
+				break;
+			}
+		}
+		Kinds[type] = index;
+		return index;
+	}
+
+	AActor *GetOwner(AActor *item) const
+	{
+		return OwnerField != nullptr ? *(AActor **)((uint8_t *)item + OwnerField->Offset) : nullptr;
+	}
+
+	bool IsOwnedBy(AActor *owner, int index) const
+	{
+		AActor *item = Items[index];
+		return !(item->ObjectFlags & OF_EuthanizeMe) && GetOwner(item) == owner;
+	}
+};
+
+void AActor::InvalidateInventoryIndex ()
+{
+	if (InventoryIndex != nullptr)
+	{
+		delete InventoryIndex;
+		InventoryIndex = nullptr;
+	}
+}
+
+DEFINE_ACTION_FUNCTION(AActor, InvalidateInventoryIndex)
+{
+	PARAM_SELF_PROLOGUE(AActor);
+	self->InvalidateInventoryIndex();
+	return 0;
+}
+
 //============================================================================
 //
 // AActor :: FindInventory
@@ -697,7 +789,24 @@ AActor *AActor::FindInventory (PClassActor *type, bool subclass)
 	{
 		return NULL;
 	}
-	for (item = Inventory; item != NULL; item = item->Inventory)
+	if (InventoryIndex != nullptr)
+	{
+		if (InventoryIndex->Head == Inventory)
+		{
+			int index = InventoryIndex->Find(type, subclass);
+			if (index < 0)
+			{
+				return nullptr;
+			}
+			if (InventoryIndex->IsOwnedBy(this, index))
+			{
+				return InventoryIndex->Items[index];
+			}
+		}
+		InvalidateInventoryIndex();
+	}
+	int count = 0;
+	for (item = Inventory; item != NULL; item = item->Inventory, count++)
 	{
 		if (!subclass)
 		{
@@ -714,6 +823,10 @@ AActor *AActor::FindInventory (PClassActor *type, bool subclass)
 			}
 		}
 	}
+	if (count >= INVINDEX_MINITEMS)
+	{
+		InventoryIndex = new FInventoryIndex(Inventory);
+	}
 	return item;
 }
 
@@ -730,6 +843,74 @@ DEFINE_ACTION_FUNCTION(AActor, FindInventory)
 	ACTION_RETURN_OBJECT(self->FindInventory(type, subclass));
 }
 
+//============================================================================
+//
+// CCMD benchinventory
+//
+// Times FindInventory on the player's inventory against walking the chain,
+// looking up every carried class exactly and every parent class by subclass.
+//
+//============================================================================
+
+CCMD(benchinventory)
+{
+	AActor *mo = players[consoleplayer].mo;
+	if (mo == nullptr)
+	{
+		return;
+	}
+	int passes = C_BenchCount(argv, 1, 1000);
+
+	TArray<PClassActor *> types;
+	TArray<bool> subclass;
+	int items = 0;
+	for (AActor *item = mo->Inventory; item != nullptr; item = item->Inventory, items++)
+	{
+		types.Push(item->GetClass());
+		subclass.Push(false);
+		types.Push(static_cast<PClassActor *>(item->GetClass()->ParentClass));
+		subclass.Push(true);
+	}
+	if (items == 0)
+	{
+		Printf("No inventory to look up\n");
+		return;
+	}
+
+	auto walk = [=](PClassActor *type, bool sub)
+	{
+		AActor *item;
+		for (item = mo->Inventory; item != nullptr; item = item->Inventory)
+		{
+			if (sub ? item->IsKindOf(type) : item->GetClass() == type) break;
+		}
+		return item;
+	};
+
+	bool mismatch = false;
+	for (unsigned i = 0; i < types.Size(); i++)
+	{
+		mismatch |= mo->FindInventory(types[i], subclass[i]) != walk(types[i], subclass[i]);
+	}
+
+	uint64_t walktime = C_BenchTime(passes, [&](int)
+	{
+		for (unsigned i = 0; i < types.Size(); i++)
+			mismatch |= walk(types[i], subclass[i]) == nullptr;
+	});
+	uint64_t indextime = C_BenchTime(passes, [&](int)
+	{
+		for (unsigned i = 0; i < types.Size(); i++)
+			mismatch |= mo->FindInventory(types[i], subclass[i]) == nullptr;
+	});
+
+	double lookups = (double)passes * types.Size();
+	Printf("%d items, %.0f lookups:  chain %.3f ms  %s %.3f ms %s, %.1f ns saved per lookup\n",
+		items, lookups, walktime * 1e-6, mo->InventoryIndex != nullptr ? "index" : "chain (no index)", indextime * 1e-6,
+		C_BenchSpeedup(walktime, indextime).GetChars(), ((double)walktime - (double)indextime) / lookups);
+	C_BenchCheck(mismatch, "Indexed and chain lookups returned different items!");
+}
+
 //============================================================================
 //
 // AActor :: GiveInventoryType
@@ -825,6 +1006,8 @@ void AActor::ObtainInventory (AActor *other)
 {
 	assert (Inventory == NULL);
 
+	InvalidateInventoryIndex();
+	other->InvalidateInventoryIndex();
 	Inventory = other->Inventory;
 	InventoryID = other->InventoryID;
 	other->Inventory = NULL;
@@ -2941,7 +3124,7 @@ void P_NightmareRespawn (AActor *mobj)
 }
 
 
-AActor *AActor::TIDHash[128];
+AActor *AActor::TIDHash[TIDHASHSIZE];
 
 //
 // P_ClearTidHashes
@@ -3002,6 +3185,88 @@ void AActor::RemoveFromHash ()
 	tid = 0;
 }
 
+//==========================================================================
+//
+// AActor :: LinkToClassList
+//
+// Actors are kept in one list per class while they are in one of the
+// statnums TThinkerIterator searches by default, i.e. from spawning until
+// they are destroyed or moved to a non-thinking statnum.
+//
+//==========================================================================
+
+void AActor::LinkToClassList ()
+{
+	if (cprev != nullptr || (ObjectFlags & OF_EuthanizeMe))
+	{
+		return;
+	}
+	AActor **head = &GetClass()->ActorInfo()->FirstActor;
+	cnext = *head;
+	cprev = head;
+	*head = this;
+	if (cnext != nullptr)
+	{
+		cnext->cprev = &cnext;
+	}
+}
+
+void AActor::UnlinkFromClassList ()
+{
+	if (cprev != nullptr)
+	{
+		*cprev = cnext;
+		if (cnext != nullptr)
+		{
+			cnext->cprev = cprev;
+		}
+		cprev = nullptr;
+		cnext = nullptr;
+	}
+}
+
+//==========================================================================
+//
+// FActorClassIterator
+//
+//==========================================================================
+
+FActorClassIterator::FActorClassIterator (PClassActor *cls, bool exact)
+	: type(cls), index(0), next(nullptr)
+{
+	if (cls == nullptr)
+	{
+		classes = nullptr;
+		numclasses = 0;
+	}
+	else if (exact)
+	{
+		classes = &type;
+		numclasses = 1;
+	}
+	else
+	{
+		auto &subclasses = cls->ActorInfo()->Subclasses;
+		if (subclasses.Size() == 0)
+		{
+			for (auto other : PClassActor::AllActorClasses)
+			{
+				if (other->IsDescendantOf(cls))
+				{
+					subclasses.Push(other);
+				}
+			}
+		}
+		classes = &subclasses[0];
+		numclasses = subclasses.Size();
+	}
+}
+
+AActor *FActorClassIterator::GetFirst (PClassActor *cls)
+{
+	return cls->ActorInfo()->FirstActor;
+}
+
 //==========================================================================
 //
 // P_IsTIDUsed
@@ -3013,7 +3278,7 @@ void AActor::RemoveFromHash ()
 
 bool P_IsTIDUsed(int tid)
 {
-	AActor *probe = AActor::TIDHash[tid & 127];
+	AActor *probe = AActor::TIDHash[AActor::TIDHASH(tid)];
 	while (probe != NULL)
 	{
 		if (probe->tid == tid)
@@ -3092,6 +3357,60 @@ CCMD(utid)
 		(argv.argc() > 2 && atoi(argv[2]) >= 0) ? atoi(argv[2]) : 0));
 }
 
+//==========================================================================
+//
+// CCMD benchactorclass
+//
+// Times finding all actors of a class (and its subclasses) by walking the
+// thinker lists against going through the per class lists.
+//
+//==========================================================================
+
+CCMD(benchactorclass)
+{
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: benchactorclass <classname> [passes]\n");
+		return;
+	}
+	PClassActor *cls = PClass::FindActor(argv[1]);
+	if (cls == nullptr)
+	{
+		Printf("Unknown actor class '%s'\n", argv[1]);
+		return;
+	}
+	int passes = C_BenchCount(argv, 2, 100);
+
+	TArray<AActor *> walked, listed;
+	AActor *actor;
+	{
+		TThinkerIterator<AActor> it(cls);
+		while ((actor = it.Next())) walked.Push(actor);
+		FActorClassIterator cit(cls);
+		while ((actor = cit.Next())) listed.Push(actor);
+	}
+	std::sort(walked.begin(), walked.end());
+	std::sort(listed.begin(), listed.end());
+	bool mismatch = walked.Size() != listed.Size() || (walked.Size() > 0 && memcmp(&walked[0], &listed[0], walked.Size() * sizeof(AActor *)));
+
+	int found = 0;
+	uint64_t walktime = C_BenchTime(passes, [&](int)
+	{
+		TThinkerIterator<AActor> it(cls);
+		while (it.Next()) found++;
+	});
+	uint64_t listtime = C_BenchTime(passes, [&](int)
+	{
+		FActorClassIterator it(cls);
+		while (it.Next()) found--;
+	});
+
+	Printf("%u actors of %s, %d passes:  thinker walk %.3f ms  class lists %.3f ms %s\n",
+		walked.Size(), cls->TypeName.GetChars(), passes, walktime * 1e-6, listtime * 1e-6,
+		C_BenchSpeedup(walktime, listtime).GetChars());
+	C_BenchCheck(mismatch || found != 0, "Thinker walk and class lists found different actors!");
+}
+
 //==========================================================================
 //
 // AActor :: GetMissileDamage
@@ -4418,6 +4737,7 @@ AActor *AActor::StaticSpawn (PClassActor *type, const DVector3 &pos, replace_t a
 	AActor *actor;
 	
 	actor = static_cast<AActor *>(const_cast<PClassActor *>(type)->CreateNew ());
+	actor->LinkToClassList ();
 	actor->SpawnTime = level.totaltime;
 	actor->SpawnOrder = level.spawnindex++;
 
@@ -4842,6 +5162,7 @@ void AActor::OnDestroy ()
 	//      note: if OnDestroy is ever made optional, E_WorldThingDestroyed should still be called for ANY thing.
 	E_WorldThingDestroyed(this);
 
+	UnlinkFromClassList ();
 	ClearRenderSectorList();
 	ClearRenderLineList();
 
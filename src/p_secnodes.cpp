@@ -27,6 +27,8 @@
 #include "g_levellocals.h"
 #include "p_maputl.h"
 #include "actor.h"
+#include "c_dispatch.h"
+#include "c_bench.h"
 
 //=============================================================================
 // phares 3/21/98
@@ -36,6 +38,7 @@
 
 msecnode_t *headsecnode = nullptr;
 FMemArena secnodearena;
+unsigned secnodegeneration;
 
 //=============================================================================
 //
@@ -113,6 +116,7 @@ nodetype *P_AddSecnode(linktype *s, AActor *thing, nodetype *nextnode, nodetype
 	// of the list.
 
 	node = (nodetype*)P_GetSecnode();
+	secnodegeneration++;
 
 	// killough 4/4/98, 4/7/98: mark new nodes unvisited.
 	node->visited = 0;
@@ -182,6 +186,7 @@ nodetype *P_DelSecnode(nodetype *node, nodetype *linktype::*listhead)
 		// Return this node to the freelist
 
 		P_PutSecnode((msecnode_t*)node);
+		secnodegeneration++;
 		return tn;
 	}
 	return nullptr;
@@ -444,3 +449,60 @@ void AActor::ClearRenderLineList()
 	P_DelSeclist(touching_lineportallist, &FLinePortal::lineportal_thinglist);
 	touching_lineportallist = nullptr;
 }
+
+//==========================================================================
+//
+// CCMD benchsecnodes
+//
+// Times a pass over the thing lists of all sectors that does nothing with
+// the things, once with the rescanning loop P_ChangeSector used to have and
+// once with P_ScanSectorThings.
+//
+//==========================================================================
+
+CCMD(benchsecnodes)
+{
+	if (gamestate != GS_LEVEL || level.sectors.Size() == 0)
+	{
+		Printf("benchsecnodes can only be used in a level\n");
+		return;
+	}
+
+	int count = C_BenchCount(argv, 1, 1);
+	uint64_t things[2] = { 0, 0 };
+
+	uint64_t rescantime = C_BenchTime(count, [&](int)
+	{
+		for (auto &sec : level.sectors)
+		{
+			msecnode_t *n;
+			for (n = sec.touching_thinglist; n; n = n->m_snext)
+				n->visited = false;
+			do
+			{
+				for (n = sec.touching_thinglist; n; n = n->m_snext)
+				{
+					if (!n->visited)
+					{
+						n->visited = true;
+						things[0]++;
+						break;
+					}
+				}
+			} while (n);
+		}
+	});
+
+	uint64_t resumetime = C_BenchTime(count, [&](int)
+	{
+		for (auto &sec : level.sectors)
+		{
+			P_ScanSectorThings(&sec, [&](AActor *) { things[1]++; });
+		}
+	});
+
+	Printf("%llu things in %u sectors\n", (unsigned long long)(things[0] / count), level.sectors.Size());
+	Printf("Rescanning: %.3f ms\n", rescantime * 1e-6 / count);
+	Printf("Resuming:   %.3f ms %s\n", resumetime * 1e-6 / count, C_BenchSpeedup(rescantime, resumetime).GetChars());
+	C_BenchCheck(things[0] != things[1], "Thing counts differ!");
+}
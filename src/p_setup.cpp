@@ -435,14 +435,14 @@ void MapLoader::LoadVertexes(MapData * map)
 //
 //===========================================================================
 
-void MapLoader::LoadZSegs (FileReader &data)
+void MapLoader::LoadZSegs (FileReader &data, bool widelines)
 {
 	for (auto &seg : Level->segs)
 	{
 		line_t *ldef;
 		uint32_t v1 = data.ReadUInt32();
 		uint32_t v2 = data.ReadUInt32();
-		uint16_t line = data.ReadUInt16();
+		uint32_t line = widelines ? data.ReadUInt32() : data.ReadUInt16();
 		uint8_t side = data.ReadUInt8();
 
 		seg.v1 = &Level->vertexes[v1];
@@ -602,9 +602,9 @@ void MapLoader::LoadZNodes(FileReader &data, int glnodes)
 		sub.firstline = &Level->segs[(size_t)sub.firstline];
 	}
 
-	if (glnodes == 0)
+	if (glnodes == 0 || glnodes == 4)
 	{
-		LoadZSegs (data);
+		LoadZSegs (data, glnodes == 4);
 	}
 	else
 	{
@@ -694,6 +694,13 @@ void MapLoader::LoadExtendedNodes (FileReader &dalump, uint32_t id)
 		compressed = false;
 		break;
 
+	// Regular nodes with 32-bit line numbers and partition lines.
+	// Only used by the level cache.
+	case MAKE_ID('Z','N','O','3'):
+		type = 4;
+		compressed = true;
+		break;
+
 	case MAKE_ID('X','G','L','N'):
 		type = 1;
 		compressed = false;
@@ -2501,6 +2508,7 @@ void MapLoader::CreateBlockMap ()
 	{
 		Level->blockmap.blockmaplump[ii] = BlockMap[ii];
 	}
+	GeneratedBlockmapSize = BlockMap.Size();
 }
 
 
@@ -2608,8 +2616,11 @@ void MapLoader::LoadBlockMap (MapData * map)
 		Args->CheckParm("-blockmap")
 		)
 	{
-		DPrintf (DMSG_SPAMMY, "Generating BLOCKMAP\n");
-		CreateBlockMap ();
+		if (!CheckCachedBlockmap(map))
+		{
+			DPrintf (DMSG_SPAMMY, "Generating BLOCKMAP\n");
+			CreateBlockMap ();
+		}
 	}
 	else
 	{
@@ -2640,8 +2651,13 @@ void MapLoader::LoadBlockMap (MapData * map)
 
 		if (!Level->blockmap.VerifyBlockMap(count, Level->lines.Size()))
 		{
-			DPrintf (DMSG_SPAMMY, "Generating BLOCKMAP\n");
-			CreateBlockMap();
+			delete[] Level->blockmap.blockmaplump;
+			Level->blockmap.blockmaplump = nullptr;
+			if (!CheckCachedBlockmap(map))
+			{
+				DPrintf (DMSG_SPAMMY, "Generating BLOCKMAP\n");
+				CreateBlockMap();
+			}
 		}
 
 	}
@@ -2655,6 +2671,11 @@ void MapLoader::LoadBlockMap (MapData * map)
 	count = Level->blockmap.bmapwidth*Level->blockmap.bmapheight;
 	Level->blockmap.blocklinks = new FBlockNode *[count];
 	memset (Level->blockmap.blocklinks, 0, count*sizeof(*Level->blockmap.blocklinks));
+	Level->blockmap.superwidth = (Level->blockmap.bmapwidth + FBlockmap::SUPERBLOCKSIZE - 1) >> FBlockmap::SUPERBLOCKSHIFT;
+	Level->blockmap.superheight = (Level->blockmap.bmapheight + FBlockmap::SUPERBLOCKSIZE - 1) >> FBlockmap::SUPERBLOCKSHIFT;
+	count = Level->blockmap.superwidth*Level->blockmap.superheight;
+	Level->blockmap.superblockcounts = new int[count];
+	memset (Level->blockmap.superblockcounts, 0, count*sizeof(*Level->blockmap.superblockcounts));
 	Level->blockmap.blockmap = Level->blockmap.blockmaplump+4;
 }
 
@@ -3183,6 +3204,7 @@ void P_FreeLevelData ()
 //===========================================================================
 
 extern FMemArena secnodearena;
+extern FMemArena blocknodearena;
 extern msecnode_t *headsecnode;
 
 void P_FreeExtraLevelData()
@@ -3190,16 +3212,8 @@ void P_FreeExtraLevelData()
 	// Free all blocknodes and msecnodes.
 	// *NEVER* call this function without calling
 	// P_FreeLevelData() first, or they might not all be freed.
-	{
-		FBlockNode *node = FBlockNode::FreeBlocks;
-		while (node != nullptr)
-		{
-			FBlockNode *next = node->NextBlock;
-			delete node;
-			node = next;
-		}
-		FBlockNode::FreeBlocks = nullptr;
-	}
+	blocknodearena.FreeAllBlocks();
+	FBlockNode::FreeBlocks = nullptr;
 	secnodearena.FreeAllBlocks();
 	headsecnode = nullptr;
 }
@@ -3525,10 +3539,13 @@ void P_SetupLevel(const char *lumpname, int position, bool newGame)
 		// If loading the regular nodes failed try GL nodes before considering a rebuild
 		if (ForceNodeBuild)
 		{
-			if (loader.LoadGLNodes(map))
+			// Cached regular nodes can only be used if nothing asks for GL nodes.
+			bool needGLNodes = RequireGLNodes || multiplayer || demoplayback || demorecording || genglnodes;
+			if (loader.LoadGLNodes(map) || (!needGLNodes && loader.CheckCachedNodes(map, false)))
 			{
 				ForceNodeBuild = false;
 				reloop = true;
+				oldvertextable = loader.GetCachedVertexTable();
 			}
 		}
 	}
@@ -3560,6 +3577,7 @@ void P_SetupLevel(const char *lumpname, int position, bool newGame)
 		endTime = I_msTime();
 		DPrintf(DMSG_NOTIFY, "BSP generation took %.3f sec (%d segs)\n", (endTime - startTime) * 0.001, level.segs.Size());
 		oldvertextable = builder.GetOldVertexTable();
+		loader.RequestLevelCache(BuildGLNodes, (int)(endTime - startTime), oldvertextable, leveldata.NumVertices);
 		reloop = true;
 	}
 	else
@@ -3591,7 +3609,7 @@ void P_SetupLevel(const char *lumpname, int position, bool newGame)
 		// If the original nodes being loaded are not GL nodes they will be kept around for
 		// use in P_PointInSubsector to avoid problems with maps that depend on the specific
 		// nodes they were built with (P:AR E1M3 is a good example for a map where this is the case.)
-		reloop |= loader.CheckNodes(map, BuildGLNodes, (uint32_t)(endTime - startTime));
+		reloop |= loader.CheckNodes(map, BuildGLNodes);
 	}
 	else
 	{
@@ -3609,6 +3627,9 @@ void P_SetupLevel(const char *lumpname, int position, bool newGame)
 	loader.LoadReject(map, buildmap);
 	times[11].Unclock();
 
+	// Now that the blockmap is known, store everything that was generated.
+	loader.WriteLevelCache(map);
+
 	times[12].Clock();
 	loader.GroupLines(buildmap);
 	times[12].Unclock();
@@ -299,7 +299,14 @@ class MapLoader
 	bool LoadGLSubsectors(FileReader &lump);
 	bool LoadNodes(FileReader &lump);
 	bool DoLoadGLNodes(FileReader * lumps);
-	void CreateCachedNodes(MapData *map);
+	bool CheckCachedBlockmap(MapData *map);
+
+	// Level preprocessing cache state, see p_glnodes.cpp
+	bool CacheLevel = false;
+	bool CacheGLNodes = false;
+	TArray<int> CacheVertexTable;
+	TArray<int> CachedVertexTable;
+	unsigned GeneratedBlockmapSize = 0;
 
 	void SetTexture(side_t *side, int position, const char *name, FMissingTextureTracker &track);
 	void SetTexture(sector_t *sector, int index, int position, const char *name, FMissingTextureTracker &track, bool truncate);
@@ -308,7 +315,7 @@ class MapLoader
 
 	void FloodZone(sector_t *sec, int zonenum);
 	void LoadGLZSegs(FileReader &data, int type);
-	void LoadZSegs(FileReader &data);
+	void LoadZSegs(FileReader &data, bool widelines);
 	void LoadZNodes(FileReader &data, int glnodes);
 
 	int DetermineTranslucency(int lumpnum);
@@ -334,8 +341,11 @@ public:
 	template<class subsectortype, class segtype> void LoadSubsectors(MapData * map);
 	template<class nodetype, class subsectortype> void LoadNodes(MapData * map);
 	bool LoadGLNodes(MapData * map);
-	bool CheckCachedNodes(MapData *map);
-	bool CheckNodes(MapData * map, bool rebuilt, int buildtime);
+	bool CheckCachedNodes(MapData *map, bool requireGL = true);
+	const int *GetCachedVertexTable();
+	void RequestLevelCache(bool glnodes, int buildtime, const int *oldvertextable, unsigned numoldverts);
+	void WriteLevelCache(MapData *map);
+	bool CheckNodes(MapData * map, bool rebuilt);
 	bool CheckForGLNodes();
 
 	void LoadSectors(MapData *map, FMissingTextureTracker &missingtex);
@@ -831,6 +831,12 @@ sightcounts[2]++;
 =
 = killough 4/20/98: cleaned up, made to use new LOS struct
 =
+= The results are not cached between calls. Monsters move every tic, so a
+= key with exact positions almost never hits, and a coarser key changes the
+= results and with them demo sync. Queries can't be batched or run in
+= parallel either, since the traversal works on static intercept and portal
+= lists and the global validcount.
+=
 =====================
 */
 
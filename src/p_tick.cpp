@@ -37,9 +37,12 @@
 #include "g_levellocals.h"
 #include "events.h"
 #include "actorinlines.h"
+#include "stats.h"
 
 extern gamestate_t wipegamestate;
 
+cycle_t ParticleCycles, WorldTickCycles;
+
 //==========================================================================
 //
 // P_CheckTickerPaused
@@ -128,7 +131,9 @@ void P_Ticker (void)
 	// Since things will be moving, it's okay to interpolate them in the renderer.
 	r_NoInterpolate = false;
 
+	ParticleCycles.Clock();
 	P_ThinkParticles();	// [RH] make the particles think
+	ParticleCycles.Unclock();
 
 	for (i = 0; i<MAXPLAYERS; i++)
 		if (playeringame[i] &&
@@ -136,7 +141,9 @@ void P_Ticker (void)
 			P_PlayerThink (&players[i]);
 
 	// [ZZ] call the WorldTick hook
+	WorldTickCycles.Clock();
 	E_WorldTick();
+	WorldTickCycles.Unclock();
 	StatusBar->CallTick ();		// [RH] moved this here
 	level.Tick ();			// [RH] let the level tick
 	DThinker::RunThinkers ();
@@ -50,16 +50,17 @@ inline void parallel_for(const Index first, const Index last, const Index step,
 	});
 }
 
-#else // Generic loop with optional OpenMP parallelization
+#else // Run on the engine's shared worker threads
+
+#include "threadpool.h"
 
 template <typename Index, typename Function>
 inline void parallel_for(const Index first, const Index last, const Index step, const Function& function)
 {
-#pragma omp parallel for
-	for (Index i = first; i < last; i += step)
+	FThreadPool::Instance()->ParallelFor(int(first), int(last), int(step), [&](int i)
 	{
-		function(i);
-	}
+		function(Index(i));
+	});
 }
 
 #endif // HAVE_PARALLEL_FOR
@@ -330,6 +330,28 @@ bool PolyTriangleThreadData::IsDegenerate(const ShadedTriVertex *vert)
 	return crosslengthsqr <= 1.e-6f;
 }
 
+bool PolyTriangleThreadData::IsOutsideBand(const ShadedTriVertex *vert)
+{
+	// Only triangles fully in front of the near plane can be projected before clipping
+	if (vert[0].w <= 0.0f || vert[1].w <= 0.0f || vert[2].w <= 0.0f)
+		return false;
+
+	float minY = FLT_MAX, maxY = -FLT_MAX;
+	for (int i = 0; i < 3; i++)
+	{
+		float y = viewport_y + viewport_height * (1.0f - vert[i].y / vert[i].w) * 0.5f;
+		minY = MIN(minY, y);
+		maxY = MAX(maxY, y);
+	}
+
+	// Leave a line of slack on both sides so rounding never drops a covered line
+	if (minY < -1.e6f || maxY > 1.e6f)
+		return false;
+	int first_line = (int)minY - 1;
+	int end_line = MIN((int)maxY + 2, numa_end_y);
+	return first_line + skipped_by_thread(first_line) >= end_line;
+}
+
 bool PolyTriangleThreadData::IsFrontfacing(TriDrawTriangleArgs *args)
 {
 	float a =
@@ -345,6 +367,10 @@ void PolyTriangleThreadData::DrawShadedTriangle(const ShadedTriVertex *vert, boo
 	if (IsDegenerate(vert))
 		return;
 
+	// Reject triangle if it does not touch any of the lines owned by this thread
+	if (IsOutsideBand(vert))
+		return;
+
 	// Cull, clip and generate additional vertices as needed
 	ShadedTriVertex clippedvert[max_additional_vertices];
 	int numclipvert = ClipEdge(vert, clippedvert);
@@ -626,7 +652,7 @@ int PolyTriangleThreadData::ClipEdge(const ShadedTriVertex *verts, ShadedTriVert
 PolyTriangleThreadData *PolyTriangleThreadData::Get(DrawerThread *thread)
 {
 	if (!thread->poly)
-		thread->poly = std::make_shared<PolyTriangleThreadData>(thread->core, thread->num_cores, thread->numa_node, thread->num_numa_nodes, thread->numa_start_y, thread->numa_end_y);
+		thread->poly = std::make_shared<PolyTriangleThreadData>(thread->core, thread->num_cores, thread->numa_start_y, thread->numa_end_y);
 	return thread->poly.get();
 }
 
@@ -50,7 +50,7 @@ public:
 class PolyTriangleThreadData
 {
 public:
-	PolyTriangleThreadData(int32_t core, int32_t num_cores, int32_t numa_node, int32_t num_numa_nodes, int numa_start_y, int numa_end_y) : core(core), num_cores(num_cores), numa_node(numa_node), num_numa_nodes(num_numa_nodes), numa_start_y(numa_start_y), numa_end_y(numa_end_y) { }
+	PolyTriangleThreadData(int32_t core, int32_t num_cores, int numa_start_y, int numa_end_y) : core(core), num_cores(num_cores), numa_start_y(numa_start_y), numa_end_y(numa_end_y) { }
 
 	void ClearStencil(uint8_t value);
 	void SetViewport(int x, int y, int width, int height, uint8_t *dest, int dest_width, int dest_height, int dest_pitch, bool dest_bgra);
@@ -65,8 +65,6 @@ public:
 
 	int32_t core;
 	int32_t num_cores;
-	int32_t numa_node;
-	int32_t num_numa_nodes;
 
 	int numa_start_y;
 	int numa_end_y;
@@ -114,6 +112,7 @@ private:
 	ShadedTriVertex ShadeVertex(const PolyDrawArgs &drawargs, const void *vertices, int index);
 	void DrawShadedTriangle(const ShadedTriVertex *vertices, bool ccw, TriDrawTriangleArgs *args);
 	static bool IsDegenerate(const ShadedTriVertex *vertices);
+	bool IsOutsideBand(const ShadedTriVertex *vertices);
 	static bool IsFrontfacing(TriDrawTriangleArgs *args);
 	static int ClipEdge(const ShadedTriVertex *verts, ShadedTriVertex *clippedvert);
 
@@ -187,10 +187,13 @@ void RenderPolyScene::RenderSubsector(PolyRenderThread *thread, subsector_t *sub
 	}
 
 	int subsectorIndex = sub->Index();
-	for (int i = ParticlesInSubsec[subsectorIndex]; i != NO_PARTICLE; i = Particles[i].snext)
-	{
-		particle_t *particle = &Particles[i];
-		thread->TranslucentObjects.push_back(thread->FrameMemory->NewObject<PolyTranslucentParticle>(particle, sub, subsectorDepth, CurrentViewpoint->StencilValue));
+	if ((unsigned int)subsectorIndex < level.subsectors.Size())
+	{ // Only do it for the main BSP.
+		for (uint32_t j = ParticlesInSubsec[subsectorIndex]; j < ParticlesInSubsec[subsectorIndex + 1]; j++)
+		{
+			particle_t *particle = &Particles[ParticleBins[j]];
+			thread->TranslucentObjects.push_back(thread->FrameMemory->NewObject<PolyTranslucentParticle>(particle, sub, subsectorDepth, CurrentViewpoint->StencilValue));
+		}
 	}
 }
 
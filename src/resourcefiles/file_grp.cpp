@@ -34,6 +34,7 @@
 */
 
 #include "resourcefile.h"
+#include "v_text.h"
 #include "w_wad.h"
 
 //==========================================================================
@@ -96,27 +97,44 @@ FGrpFile::FGrpFile(const char *filename, FileReader &file)
 bool FGrpFile::Open(bool quiet)
 {
 	GrpInfo header;
+	auto grpSize = Reader.GetLength();
 
 	Reader.Read(&header, sizeof(header));
 	NumLumps = LittleLong(header.NumLumps);
+
+	if (grpSize < (ptrdiff_t)sizeof(GrpInfo) || NumLumps > (grpSize - sizeof(GrpInfo)) / sizeof(GrpLump))
+	{
+		if (!quiet) Printf(TEXTCOLOR_RED "\n%s: Directory corrupted.\n", FileName.GetChars());
+		return false;
+	}
 	
 	GrpLump *fileinfo = new GrpLump[NumLumps];
 	Reader.Read (fileinfo, NumLumps * sizeof(GrpLump));
 
 	Lumps.Resize(NumLumps);
 
-	int Position = sizeof(GrpInfo) + NumLumps * sizeof(GrpLump);
+	int64_t Position = sizeof(GrpInfo) + NumLumps * sizeof(GrpLump);
 
 	for(uint32_t i = 0; i < NumLumps; i++)
 	{
+		uint32_t size = LittleLong(fileinfo[i].Size);
 		Lumps[i].Owner = this;
-		Lumps[i].Position = Position;
-		Lumps[i].LumpSize = LittleLong(fileinfo[i].Size);
-		Position += fileinfo[i].Size;
+		Lumps[i].Position = (int)Position;
+		Lumps[i].LumpSize = size;
 		Lumps[i].Namespace = ns_global;
 		Lumps[i].Flags = 0;
 		fileinfo[i].NameWithZero[12] = '\0';	// Be sure filename is null-terminated
 		Lumps[i].LumpNameSetup(fileinfo[i].NameWithZero);
+
+		// The lumps are stored back to back, so a lump that does not fit also leaves nothing for the ones after it.
+		if (size > grpSize - Position)
+		{
+			Printf(PRINT_HIGH, "%s: Lump %s contains invalid positioning info and will be ignored\n", FileName.GetChars(), Lumps[i].FullName.GetChars());
+			Lumps[i].LumpSize = Lumps[i].Position = 0;
+			size = 0;
+			Position = grpSize;
+		}
+		Position += size;
 	}
 	if (!quiet && !batchrun) Printf(", %d lumps\n", NumLumps);
 
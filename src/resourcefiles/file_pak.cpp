@@ -33,6 +33,7 @@
 */
 
 #include "resourcefile.h"
+#include "v_text.h"
 #include "w_wad.h"
 
 //==========================================================================
@@ -91,10 +92,17 @@ FPakFile::FPakFile(const char *filename, FileReader &file)
 bool FPakFile::Open(bool quiet)
 {
 	dpackheader_t header;
+	auto pakSize = Reader.GetLength();
 
 	Reader.Read(&header, sizeof(header));
 	NumLumps = LittleLong(header.dirlen) / sizeof(dpackfile_t);
 	header.dirofs = LittleLong(header.dirofs);
+
+	if (header.dirofs < 0 || header.dirofs > pakSize || NumLumps > (pakSize - header.dirofs) / sizeof(dpackfile_t))
+	{
+		if (!quiet) Printf(TEXTCOLOR_RED "\n%s: Directory corrupted.\n", FileName.GetChars());
+		return false;
+	}
 	
 	TArray<dpackfile_t> fileinfo(NumLumps, true);
 	Reader.Seek (header.dirofs, FileReader::SeekSet);
@@ -110,6 +118,16 @@ bool FPakFile::Open(bool quiet)
 		Lumps[i].Owner = this;
 		Lumps[i].Position = LittleLong(fileinfo[i].filepos);
 		Lumps[i].LumpSize = LittleLong(fileinfo[i].filelen);
+
+		// Check if the lump is within the PAK file and print a warning if not.
+		if (Lumps[i].Position < 0 || Lumps[i].LumpSize < 0 || Lumps[i].LumpSize > pakSize - Lumps[i].Position)
+		{
+			if (Lumps[i].LumpSize != 0)
+			{
+				Printf(PRINT_HIGH, "%s: Lump %s contains invalid positioning info and will be ignored\n", FileName.GetChars(), Lumps[i].FullName.GetChars());
+			}
+			Lumps[i].LumpSize = Lumps[i].Position = 0;
+		}
 		Lumps[i].CheckEmbedded();
 	}
 
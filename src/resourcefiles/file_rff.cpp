@@ -35,6 +35,7 @@
 
 #include "resourcefile.h"
 #include "templates.h"
+#include "v_text.h"
 #include "w_wad.h"
 
 //==========================================================================
@@ -138,11 +139,18 @@ bool FRFFFile::Open(bool quiet)
 {
 	RFFLump *lumps;
 	RFFInfo header;
+	auto rffSize = Reader.GetLength();
 
 	Reader.Read(&header, sizeof(header));
 
 	NumLumps = LittleLong(header.NumLumps);
 	header.DirOfs = LittleLong(header.DirOfs);
+
+	if (header.DirOfs > rffSize || NumLumps > (rffSize - header.DirOfs) / sizeof(RFFLump))
+	{
+		if (!quiet) Printf(TEXTCOLOR_RED "\n%s: Directory corrupted.\n", FileName.GetChars());
+		return false;
+	}
 	lumps = new RFFLump[header.NumLumps];
 	Reader.Seek (header.DirOfs, FileReader::SeekSet);
 	Reader.Read (lumps, header.NumLumps * sizeof(RFFLump));
@@ -181,6 +189,16 @@ bool FRFFFile::Open(bool quiet)
 		{
 			Lumps[i].Namespace = ns_bloodraw;
 		}
+
+		// Check if the lump is within the RFF file and print a warning if not.
+		if (Lumps[i].Position < 0 || Lumps[i].LumpSize < 0 || Lumps[i].LumpSize > rffSize - Lumps[i].Position)
+		{
+			if (Lumps[i].LumpSize != 0)
+			{
+				Printf(PRINT_HIGH, "%s: Lump %s contains invalid positioning info and will be ignored\n", FileName.GetChars(), Lumps[i].FullName.GetChars());
+			}
+			Lumps[i].LumpSize = Lumps[i].Position = 0;
+		}
 	}
 	delete[] lumps;
 	return true;
@@ -190,7 +190,7 @@ bool FWadFile::Open(bool quiet)
 		Lumps[i].FullName = NULL;
 		
 		// Check if the lump is within the WAD file and print a warning if not.
-		if (Lumps[i].Position + Lumps[i].LumpSize > wadSize || Lumps[i].Position < 0 || Lumps[i].LumpSize < 0)
+		if (Lumps[i].Position < 0 || Lumps[i].LumpSize < 0 || Lumps[i].LumpSize > wadSize - Lumps[i].Position)
 		{
 			if (Lumps[i].LumpSize != 0)
 			{
@@ -6087,6 +6087,11 @@ FxExpression *FxIdentifier::Resolve(FCompileContext& ctx)
 			delete this;
 			return nullptr;
 		}
+		// FxCVar compiles the address of the value into the code, which would dangle once the cvar is unset.
+		if (cvar->GetFlags() & CVAR_UNSETTABLE)
+		{
+			ScriptPosition.Message(MSG_WARNING, "CVAR '%s' can be unset from the console. Use CVar.FindCVar() to access it safely.", Identifier.GetChars());
+		}
 		newex = new FxCVar(cvar, ScriptPosition);
 		goto foundit;
 	}
@@ -8973,6 +8978,19 @@ FxExpression *FxVMFunctionCall::Resolve(FCompileContext& ctx)
 	{
 		ValueType = TypeVoid;
 	}
+
+	// A lookup of a cvar by constant name can be done once here. Cvars that can be unset from the console are excluded because the pointer would not stay valid.
+	if (ArgList.Size() == 1 && ArgList[0]->isConstant() && Function->SymbolName == FName("FindCVar") && Function->OwningClass == NewStruct("CVar", nullptr, true))
+	{
+		FBaseCVar *cvar = FindCVar(static_cast<FxConstant *>(ArgList[0])->GetValue().GetName());
+		if (cvar != nullptr && !(cvar->GetFlags() & CVAR_UNSETTABLE))
+		{
+			TypedVMValue handle((void *)cvar);
+			auto x = new FxConstant(ValueType, handle, ScriptPosition);
+			delete this;
+			return x;
+		}
+	}
 	return this;
 }
 
@@ -37,6 +37,7 @@
 #include "m_argv.h"
 #include "c_cvars.h"
 #include "scripting/vm/jit.h"
+#include "stats.h"
 
 struct VMRemap
 {
@@ -803,6 +804,8 @@ VMFunction *FFunctionBuildList::AddFunction(PNamespace *gnspc, const VersionInfo
 }
 
 
+extern cycle_t ScriptResolveCycles, ScriptEmitCycles;
+
 void FFunctionBuildList::Build()
 {
 	int codesize = 0;
@@ -833,7 +836,9 @@ void FFunctionBuildList::Build()
 		}
 
 		FScriptPosition::StrictErrors = !item.FromDecorate;
+		ScriptResolveCycles.Clock();
 		item.Code = item.Code->Resolve(ctx);
+		ScriptResolveCycles.Unclock();
 		// If we need extra space, load the frame pointer into a register so that we do not have to call the wasteful LFP instruction more than once.
 		if (item.Function->ExtraSpace > 0)
 		{
@@ -850,7 +855,9 @@ void FFunctionBuildList::Build()
 				auto newcmpd = new FxCompoundStatement(item.Code->ScriptPosition);
 				newcmpd->Add(item.Code);
 				newcmpd->Add(new FxReturnStatement(nullptr, item.Code->ScriptPosition));
+				ScriptResolveCycles.Clock();
 				item.Code = newcmpd->Resolve(ctx);
+				ScriptResolveCycles.Unclock();
 			}
 
 			item.Proto = ctx.ReturnProto;
@@ -870,6 +877,7 @@ void FFunctionBuildList::Build()
 			}
 
 			// Emit code
+			ScriptEmitCycles.Clock();
 			try
 			{
 				sfunc->SourceFileName = item.Code->ScriptPosition.FileName;	// remember the file name for printing error messages if something goes wrong in the VM.
@@ -899,6 +907,7 @@ void FFunctionBuildList::Build()
 				// catch errors from the code generator and pring something meaningful.
 				item.Code->ScriptPosition.Message(MSG_ERROR, "%s in %s", err.GetMessage(), item.PrintableName.GetChars());
 			}
+			ScriptEmitCycles.Unclock();
 		}
 		delete item.Code;
 		if (dump != nullptr)
@@ -51,6 +51,7 @@
 #include "v_text.h"
 #include "backend/codegen.h"
 #include "stats.h"
+#include "c_dispatch.h"
 #include "info.h"
 #include "thingdef.h"
 
@@ -424,11 +425,23 @@ static void CheckStates(PClassActor *obj)
 //
 // Called from FActor::StaticInit()
 //
+// Scripts are compiled from source on every launch. The compiled functions
+// refer to classes, types and states by pointer and the JIT output by
+// absolute address, so caching them across launches would first need a
+// serializer for the whole type system.
+//
 //==========================================================================
 void ParseScripts();
 void ParseAllDecorate();
 void SynthesizeFlagFields();
 
+// Startup timing of the script compiler, printed by 'scripttimes'.
+// Resolve and emit are measured per function inside FFunctionBuildList::Build.
+static cycle_t ScriptInitCycles, ScriptParseCycles, DecorateParseCycles, ScriptBuildCycles, ScriptPostprocessCycles;
+cycle_t ScriptResolveCycles, ScriptEmitCycles;
+extern cycle_t JitCompileCycles;
+extern int JitCompileCount;
+
 void LoadActors()
 {
 	cycle_t timer;
@@ -436,15 +449,32 @@ void LoadActors()
 	timer.Reset(); timer.Clock();
 	FScriptPosition::ResetErrorCounter();
 
+	ScriptInitCycles.Reset();
+	ScriptParseCycles.Reset();
+	DecorateParseCycles.Reset();
+	ScriptBuildCycles.Reset();
+	ScriptResolveCycles.Reset();
+	ScriptEmitCycles.Reset();
+	ScriptPostprocessCycles.Reset();
+
+	ScriptInitCycles.Clock();
 	InitThingdef();
+	ScriptInitCycles.Unclock();
+
 	FScriptPosition::StrictErrors = true;
+	ScriptParseCycles.Clock();
 	ParseScripts();
+	ScriptParseCycles.Unclock();
 
 	FScriptPosition::StrictErrors = false;
+	DecorateParseCycles.Clock();
 	ParseAllDecorate();
 	SynthesizeFlagFields();
+	DecorateParseCycles.Unclock();
 
+	ScriptBuildCycles.Clock();
 	FunctionBuildList.Build();
+	ScriptBuildCycles.Unclock();
 
 	if (FScriptPosition::ErrorCounter > 0)
 	{
@@ -452,6 +482,7 @@ void LoadActors()
 	}
 	FScriptPosition::ResetErrorCounter();
 
+	ScriptPostprocessCycles.Clock();
 	for (int i = PClassActor::AllActorClasses.Size() - 1; i >= 0; i--)
 	{
 		auto ti = PClassActor::AllActorClasses[i];
@@ -500,6 +531,7 @@ void LoadActors()
 			defaults->flags2 |= MF2_PASSMOBJ;
 		}
 	}
+	ScriptPostprocessCycles.Unclock();
 	if (FScriptPosition::ErrorCounter > 0)
 	{
 		I_Error("%d errors during actor postprocessing", FScriptPosition::ErrorCounter);
@@ -512,3 +544,23 @@ void LoadActors()
 	PClass::bVMOperational = true;
 	StateSourceLines.Clear();
 }
+
+//==========================================================================
+//
+// scripttimes
+//
+// Prints how long each phase of script compilation took at startup.
+// Functions are JIT compiled on demand, so that figure keeps growing
+// while the game runs.
+//
+//==========================================================================
+
+CCMD(scripttimes)
+{
+	Printf("Setup:          %8.2f ms\n", ScriptInitCycles.TimeMS());
+	Printf("ZScript parse:  %8.2f ms\n", ScriptParseCycles.TimeMS());
+	Printf("DECORATE parse: %8.2f ms\n", DecorateParseCycles.TimeMS());
+	Printf("Function build: %8.2f ms (resolve %.2f ms, emit %.2f ms)\n", ScriptBuildCycles.TimeMS(), ScriptResolveCycles.TimeMS(), ScriptEmitCycles.TimeMS());
+	Printf("Postprocess:    %8.2f ms\n", ScriptPostprocessCycles.TimeMS());
+	Printf("JIT:            %8.2f ms (%d functions compiled so far)\n", JitCompileCycles.TimeMS(), JitCompileCount);
+}
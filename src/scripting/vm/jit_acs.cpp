@@ -0,0 +1,216 @@
+
+#include "jitintern.h"
+#include "jit_acs.h"
+
+extern cycle_t JitCompileCycles;
+extern int JitCompileCount;
+
+// Compiled runs by their op sequence, so that a map that is entered again
+// or a library shared by several maps does not compile the same code twice.
+static TMap<FString, ACSJitFunc> ACSJitCache;
+static int ACSJitGen;
+
+int JitACSGeneration()
+{
+	return ACSJitGen;
+}
+
+void JitReleaseACS()
+{
+	ACSJitCache.Clear();
+	ACSJitGen++;
+}
+
+static void EmitACSRun(asmjit::X86Compiler &cc, const TArray<FACSJitOp> &ops)
+{
+	using namespace asmjit;
+
+	X86Gp stack = cc.newIntPtr("stack");
+	X86Gp locals = cc.newIntPtr("locals");
+	cc.setArg(0, stack);
+	cc.setArg(1, locals);
+
+	X86Gp a = cc.newInt32("a");
+	X86Gp b = cc.newInt32("b");
+
+	// The interpreter's stack pointer only exists at compile time. Slot i is
+	// Stack[sp + i] relative to the stack pointer on entry.
+	int depth = 0;
+	auto slot = [&](int i) { return x86::dword_ptr(stack, i * (int)sizeof(int32_t)); };
+	auto local = [&](int i) { return x86::dword_ptr(locals, i * (int)sizeof(int32_t)); };
+
+	auto binary = [&](void (*emit)(X86Compiler &cc, X86Gp a, X86Mem rhs))
+	{
+		cc.mov(a, slot(depth - 2));
+		emit(cc, a, slot(depth - 1));
+		cc.mov(slot(depth - 2), a);
+		depth--;
+	};
+
+	auto compare = [&](void (*emit)(X86Compiler &cc, X86Gp r))
+	{
+		cc.mov(a, slot(depth - 2));
+		cc.xor_(b, b);
+		cc.cmp(a, slot(depth - 1));
+		emit(cc, b.r8Lo());
+		cc.mov(slot(depth - 2), b);
+		depth--;
+	};
+
+	// Converts a slot to 0 or 1 in the given register
+	auto truth = [&](X86Gp r, int i)
+	{
+		cc.xor_(r, r);
+		cc.cmp(slot(i), 0);
+		cc.setne(r.r8Lo());
+	};
+
+	for (const FACSJitOp &op : ops)
+	{
+		switch (op.Op)
+		{
+		case ACSJIT_Push:
+			cc.mov(slot(depth), op.Arg);
+			depth++;
+			break;
+
+		case ACSJIT_Dup:
+			cc.mov(a, slot(depth - 1));
+			cc.mov(slot(depth), a);
+			depth++;
+			break;
+
+		case ACSJIT_Swap:
+			cc.mov(a, slot(depth - 2));
+			cc.mov(b, slot(depth - 1));
+			cc.mov(slot(depth - 2), b);
+			cc.mov(slot(depth - 1), a);
+			break;
+
+		case ACSJIT_Drop:
+			depth--;
+			break;
+
+		case ACSJIT_Add: binary([](X86Compiler &cc, X86Gp a, X86Mem rhs) { cc.add(a, rhs); }); break;
+		case ACSJIT_Subtract: binary([](X86Compiler &cc, X86Gp a, X86Mem rhs) { cc.sub(a, rhs); }); break;
+		case ACSJIT_Multiply: binary([](X86Compiler &cc, X86Gp a, X86Mem rhs) { cc.imul(a, rhs); }); break;
+		case ACSJIT_AndBitwise: binary([](X86Compiler &cc, X86Gp a, X86Mem rhs) { cc.and_(a, rhs); }); break;
+		case ACSJIT_OrBitwise: binary([](X86Compiler &cc, X86Gp a, X86Mem rhs) { cc.or_(a, rhs); }); break;
+		case ACSJIT_EorBitwise: binary([](X86Compiler &cc, X86Gp a, X86Mem rhs) { cc.xor_(a, rhs); }); break;
+
+		case ACSJIT_EQ: compare([](X86Compiler &cc, X86Gp r) { cc.sete(r); }); break;
+		case ACSJIT_NE: compare([](X86Compiler &cc, X86Gp r) { cc.setne(r); }); break;
+		case ACSJIT_LT: compare([](X86Compiler &cc, X86Gp r) { cc.setl(r); }); break;
+		case ACSJIT_GT: compare([](X86Compiler &cc, X86Gp r) { cc.setg(r); }); break;
+		case ACSJIT_LE: compare([](X86Compiler &cc, X86Gp r) { cc.setle(r); }); break;
+		case ACSJIT_GE: compare([](X86Compiler &cc, X86Gp r) { cc.setge(r); }); break;
+
+		case ACSJIT_AndLogical:
+		case ACSJIT_OrLogical:
+			truth(a, depth - 2);
+			truth(b, depth - 1);
+			if (op.Op == ACSJIT_AndLogical)
+				cc.and_(a, b);
+			else
+				cc.or_(a, b);
+			cc.mov(slot(depth - 2), a);
+			depth--;
+			break;
+
+		case ACSJIT_NegateLogical:
+			cc.xor_(a, a);
+			cc.cmp(slot(depth - 1), 0);
+			cc.sete(a.r8Lo());
+			cc.mov(slot(depth - 1), a);
+			break;
+
+		case ACSJIT_NegateBinary:
+			cc.not_(slot(depth - 1));
+			break;
+
+		case ACSJIT_UnaryMinus:
+			cc.neg(slot(depth - 1));
+			break;
+
+		case ACSJIT_PushLocal:
+			cc.mov(a, local(op.Arg));
+			cc.mov(slot(depth), a);
+			depth++;
+			break;
+
+		case ACSJIT_AssignLocal:
+			cc.mov(a, slot(depth - 1));
+			cc.mov(local(op.Arg), a);
+			depth--;
+			break;
+
+		case ACSJIT_AddLocal:
+			cc.mov(a, slot(depth - 1));
+			cc.add(local(op.Arg), a);
+			depth--;
+			break;
+
+		case ACSJIT_SubLocal:
+			cc.mov(a, slot(depth - 1));
+			cc.sub(local(op.Arg), a);
+			depth--;
+			break;
+
+		case ACSJIT_MulLocal:
+			cc.mov(a, local(op.Arg));
+			cc.imul(a, slot(depth - 1));
+			cc.mov(local(op.Arg), a);
+			depth--;
+			break;
+
+		case ACSJIT_IncLocal:
+			cc.add(local(op.Arg), 1);
+			break;
+
+		case ACSJIT_DecLocal:
+			cc.sub(local(op.Arg), 1);
+			break;
+		}
+	}
+
+	cc.ret();
+}
+
+ACSJitFunc JitCompileACS(const TArray<FACSJitOp> &ops)
+{
+	using namespace asmjit;
+
+	FString key;
+	for (const FACSJitOp &op : ops)
+		key.AppendFormat("%d:%d,", (int)op.Op, op.Arg);
+	ACSJitFunc *cached = ACSJitCache.CheckKey(key);
+	if (cached != nullptr)
+		return *cached;
+
+	ACSJitFunc result = nullptr;
+	JitCompileCycles.Clock();
+	try
+	{
+		ThrowingErrorHandler errorHandler;
+		CodeHolder code;
+		code.init(GetHostCodeInfo());
+		code.setErrorHandler(&errorHandler);
+
+		X86Compiler cc(&code);
+		CCFunc *func = cc.addFunc(FuncSignature2<void, int32_t *, int32_t *>());
+		EmitACSRun(cc, ops);
+		cc.endFunc();
+		cc.finalize();
+
+		result = reinterpret_cast<ACSJitFunc>(AddJitFunction(&code, func, "ACS", "", TArray<JitLineInfo>()));
+	}
+	catch (const std::exception &e)
+	{
+		Printf("ACS: Unexpected JIT error: %s\n", e.what());
+	}
+	JitCompileCycles.Unclock();
+	JitCompileCount++;
+
+	ACSJitCache[key] = result;
+	return result;
+}
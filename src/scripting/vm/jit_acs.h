@@ -0,0 +1,60 @@
+
+#pragma once
+
+#include "tarray.h"
+
+// Operations of the ACS interpreter that can be compiled to native code.
+// p_acs.cpp decodes straight runs of them from the p-code, so the compiler
+// does not have to know either of the p-code encodings.
+enum EACSJitOp
+{
+	ACSJIT_Push,			// Arg = value
+	ACSJIT_Dup,
+	ACSJIT_Swap,
+	ACSJIT_Drop,
+
+	ACSJIT_Add,
+	ACSJIT_Subtract,
+	ACSJIT_Multiply,
+	ACSJIT_EQ,
+	ACSJIT_NE,
+	ACSJIT_LT,
+	ACSJIT_GT,
+	ACSJIT_LE,
+	ACSJIT_GE,
+	ACSJIT_AndLogical,
+	ACSJIT_OrLogical,
+	ACSJIT_AndBitwise,
+	ACSJIT_OrBitwise,
+	ACSJIT_EorBitwise,
+
+	ACSJIT_NegateLogical,
+	ACSJIT_NegateBinary,
+	ACSJIT_UnaryMinus,
+
+	ACSJIT_PushLocal,		// Arg = local variable index
+	ACSJIT_AssignLocal,
+	ACSJIT_AddLocal,
+	ACSJIT_SubLocal,
+	ACSJIT_MulLocal,
+	ACSJIT_IncLocal,
+	ACSJIT_DecLocal,
+};
+
+struct FACSJitOp
+{
+	EACSJitOp Op;
+	int32_t Arg;
+};
+
+// Runs a compiled run. 'stack' points at the top of the script stack, i.e.
+// &Stack[sp]; the caller adjusts sp by the stack delta of the run afterwards.
+typedef void (*ACSJitFunc)(int32_t *stack, int32_t *locals);
+
+// Returns nullptr if the run could not be compiled. Identical runs share
+// their code.
+ACSJitFunc JitCompileACS(const TArray<FACSJitOp> &ops);
+
+// Changes whenever the JIT memory is released, which invalidates all
+// functions returned by JitCompileACS.
+int JitACSGeneration();
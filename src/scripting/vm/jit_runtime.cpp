@@ -249,12 +249,10 @@ static TArray<uint16_t> CreateUnwindInfoWindows(asmjit::CCFunc *func)
 	return info;
 }
 
-void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
+void *AddJitFunction(asmjit::CodeHolder* code, asmjit::CCFunc *func, const FString &name, const FString &filename, const TArray<JitLineInfo> &lineInfo)
 {
 	using namespace asmjit;
 
-	CCFunc *func = compiler->Codegen();
-
 	size_t codeSize = code->getCodeSize();
 	if (codeSize == 0)
 		return nullptr;
@@ -302,7 +300,7 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 	if (result == 0)
 		I_Error("RtlAddFunctionTable failed");
 
-	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName, compiler->GetScriptFunction()->SourceFileName, compiler->LineInfo, startaddr, endaddr });
+	JitDebugInfo.Push({ name, filename, lineInfo, startaddr, endaddr });
 #endif
 
 	return p;
@@ -645,12 +643,10 @@ static TArray<uint8_t> CreateUnwindInfoUnix(asmjit::CCFunc *func, unsigned int &
 	return stream;
 }
 
-void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
+void *AddJitFunction(asmjit::CodeHolder* code, asmjit::CCFunc *func, const FString &name, const FString &filename, const TArray<JitLineInfo> &lineInfo)
 {
 	using namespace asmjit;
 
-	CCFunc *func = compiler->Codegen();
-
 	size_t codeSize = code->getCodeSize();
 	if (codeSize == 0)
 		return nullptr;
@@ -726,14 +722,23 @@ void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
 #endif
 	}
 
-	JitDebugInfo.Push({ compiler->GetScriptFunction()->PrintableName, compiler->GetScriptFunction()->SourceFileName, compiler->LineInfo, startaddr, endaddr });
+	JitDebugInfo.Push({ name, filename, lineInfo, startaddr, endaddr });
 
 	return p;
 }
 #endif
 
+void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler)
+{
+	asmjit::CCFunc *func = compiler->Codegen();
+	VMScriptFunction *sfunc = compiler->GetScriptFunction();
+	return AddJitFunction(code, func, sfunc->PrintableName, sfunc->SourceFileName, compiler->LineInfo);
+}
+
 void JitRelease()
 {
+	JitReleaseACS();
+
 #ifdef _WIN64
 	for (auto p : JitFrames)
 	{
@@ -319,4 +319,6 @@ public:
 };
 
 void *AddJitFunction(asmjit::CodeHolder* code, JitCompiler *compiler);
+void *AddJitFunction(asmjit::CodeHolder* code, asmjit::CCFunc *func, const FString &name, const FString &filename, const TArray<JitLineInfo> &lineInfo);
 asmjit::CodeInfo GetHostCodeInfo();
+void JitReleaseACS();
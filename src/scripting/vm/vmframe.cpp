@@ -50,6 +50,15 @@ CUSTOM_CVAR(Bool, vm_jit, true, CVAR_NOINITCALL)
 	Printf("You must restart " GAMENAME " for this change to take effect.\n");
 	Printf("This cvar is currently not saved. You must specify it on the command line.");
 }
+
+// Number of times a function is run by the interpreter before it gets
+// compiled to native code. Most functions of a large mod are called only
+// a handful of times, if at all, so compiling them is wasted startup time.
+// 0 compiles every function on its first call.
+CUSTOM_CVAR(Int, vm_jit_threshold, 20, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+{
+	if (self < 0) self = 0;
+}
 #else
 CVAR(Bool, vm_jit, false, CVAR_NOINITCALL|CVAR_NOSET)
 FString JitCaptureStackTrace(int framesToSkip, bool includeNativeFrames) { return FString(); }
@@ -59,6 +68,10 @@ void JitRelease() {}
 cycle_t VMCycles[10];
 int VMCalls[10];
 
+// Time spent in the JIT compiler, for the startup timing report
+cycle_t JitCompileCycles;
+int JitCompileCount;
+
 #if 0
 IMPLEMENT_CLASS(VMException, false, false)
 #endif
@@ -278,14 +291,29 @@ static bool CanJit(VMScriptFunction *func)
 	return false;
 }
 
+#ifdef HAVE_VM_JIT
+static JitFuncPtr CompileScriptCall(VMScriptFunction *sfunc)
+{
+	JitCompileCycles.Clock();
+	JitFuncPtr call = JitCompile(sfunc);
+	JitCompileCycles.Unclock();
+	JitCompileCount++;
+	return call ? call : VMExec;
+}
+#endif // HAVE_VM_JIT
+
 int VMScriptFunction::FirstScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
 {
 #ifdef HAVE_VM_JIT
 	if (vm_jit && CanJit(static_cast<VMScriptFunction*>(func)))
 	{
-		func->ScriptCall = JitCompile(static_cast<VMScriptFunction*>(func));
-		if (!func->ScriptCall)
-			func->ScriptCall = VMExec;
+		if (vm_jit_threshold > 0)
+		{
+			// Interpret it until it turns out to be called often enough.
+			func->ScriptCall = &VMScriptFunction::ColdScriptCall;
+			return ColdScriptCall(func, params, numparams, ret, numret);
+		}
+		func->ScriptCall = CompileScriptCall(static_cast<VMScriptFunction*>(func));
 	}
 	else
 #endif // HAVE_VM_JIT
@@ -296,6 +324,19 @@ int VMScriptFunction::FirstScriptCall(VMFunction *func, VMValue *params, int num
 	return func->ScriptCall(func, params, numparams, ret, numret);
 }
 
+int VMScriptFunction::ColdScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret)
+{
+#ifdef HAVE_VM_JIT
+	auto sfunc = static_cast<VMScriptFunction*>(func);
+	if (++sfunc->InterpretedCalls >= (unsigned)vm_jit_threshold)
+	{
+		func->ScriptCall = CompileScriptCall(sfunc);
+		return func->ScriptCall(func, params, numparams, ret, numret);
+	}
+#endif // HAVE_VM_JIT
+	return VMExec(func, params, numparams, ret, numret);
+}
+
 int VMNativeFunction::NativeScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *returns, int numret)
 {
 	try
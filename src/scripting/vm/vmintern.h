@@ -470,6 +470,7 @@ public:
 	VM_UHALF MaxParam;		// Maximum number of parameters this function has on the stack at once
 	VM_UBYTE NumArgs;		// Number of arguments this function takes
 	TArray<FTypeAndOffset> SpecialInits;	// list of all contents on the extra stack which require construction and destruction
+	unsigned InterpretedCalls = 0;	// Calls made through the interpreter before the function was JIT compiled
 
 	void InitExtra(void *addr);
 	void DestroyExtra(void *addr);
@@ -478,4 +479,5 @@ public:
 
 private:
 	static int FirstScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret);
+	static int ColdScriptCall(VMFunction *func, VMValue *params, int numparams, VMReturn *ret, int numret);
 };
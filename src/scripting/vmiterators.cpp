@@ -386,6 +386,95 @@ DEFINE_ACTION_FUNCTION_NATIVE(DActorIterator, Reinit, ReinitActI)
 	return 0;
 }
 
+//===========================================================================
+//
+// scriptable spatial queries
+//
+// These fill the whole result array in one call instead of handing out
+// the things one by one for the script to filter.
+//
+//===========================================================================
+
+static void FinishQuery(TArray<AActor *> *results)
+{
+	for (auto thing : *results)
+	{
+		GC::WriteBarrier(thing);
+	}
+}
+
+static int SpatialRadius(TArray<AActor *> *results, double x, double y, double z, double radius, PClassActor *type, int flags, int tid, AActor *exclude)
+{
+	FThingQuery query(type, tid, flags, exclude);
+	query.InRadius(DVector3(x, y, z), radius, *results);
+	FinishQuery(results);
+	return results->Size();
+}
+
+DEFINE_ACTION_FUNCTION_NATIVE(_SpatialQuery, Radius, SpatialRadius)
+{
+	PARAM_PROLOGUE;
+	PARAM_POINTER(results, TArray<AActor *>);
+	PARAM_FLOAT(x);
+	PARAM_FLOAT(y);
+	PARAM_FLOAT(z);
+	PARAM_FLOAT(radius);
+	PARAM_CLASS(type, AActor);
+	PARAM_INT(flags);
+	PARAM_INT(tid);
+	PARAM_OBJECT(exclude, AActor);
+	ACTION_RETURN_INT(SpatialRadius(results, x, y, z, radius, type, flags, tid, exclude));
+}
+
+static int SpatialBox(TArray<AActor *> *results, double x1, double y1, double z1, double x2, double y2, double z2, PClassActor *type, int flags, int tid, AActor *exclude)
+{
+	FThingQuery query(type, tid, flags, exclude);
+	query.InBox(DVector3(x1, y1, z1), DVector3(x2, y2, z2), *results);
+	FinishQuery(results);
+	return results->Size();
+}
+
+DEFINE_ACTION_FUNCTION_NATIVE(_SpatialQuery, Box, SpatialBox)
+{
+	PARAM_PROLOGUE;
+	PARAM_POINTER(results, TArray<AActor *>);
+	PARAM_FLOAT(x1);
+	PARAM_FLOAT(y1);
+	PARAM_FLOAT(z1);
+	PARAM_FLOAT(x2);
+	PARAM_FLOAT(y2);
+	PARAM_FLOAT(z2);
+	PARAM_CLASS(type, AActor);
+	PARAM_INT(flags);
+	PARAM_INT(tid);
+	PARAM_OBJECT(exclude, AActor);
+	ACTION_RETURN_INT(SpatialBox(results, x1, y1, z1, x2, y2, z2, type, flags, tid, exclude));
+}
+
+static int SpatialNearest(TArray<AActor *> *results, double x, double y, double z, int count, double maxdist, PClassActor *type, int flags, int tid, AActor *exclude)
+{
+	FThingQuery query(type, tid, flags, exclude);
+	query.Nearest(DVector3(x, y, z), count, maxdist, *results);
+	FinishQuery(results);
+	return results->Size();
+}
+
+DEFINE_ACTION_FUNCTION_NATIVE(_SpatialQuery, Nearest, SpatialNearest)
+{
+	PARAM_PROLOGUE;
+	PARAM_POINTER(results, TArray<AActor *>);
+	PARAM_FLOAT(x);
+	PARAM_FLOAT(y);
+	PARAM_FLOAT(z);
+	PARAM_INT(count);
+	PARAM_FLOAT(maxdist);
+	PARAM_CLASS(type, AActor);
+	PARAM_INT(flags);
+	PARAM_INT(tid);
+	PARAM_OBJECT(exclude, AActor);
+	ACTION_RETURN_INT(SpatialNearest(results, x, y, z, count, maxdist, type, flags, tid, exclude));
+}
+
 DEFINE_FIELD_NAMED(DBlockLinesIterator, cres.line, curline);
 DEFINE_FIELD_NAMED(DBlockLinesIterator, cres.Position, position);
 DEFINE_FIELD_NAMED(DBlockLinesIterator, cres.portalflags, portalflags);
@@ -42,6 +42,7 @@
 #include "rapidjson/writer.h"
 #include "rapidjson/prettywriter.h"
 #include "rapidjson/document.h"
+#include "rapidjson/error/en.h"
 #include "serializer.h"
 #include "r_data/r_interpolate.h"
 #include "r_state.h"
@@ -58,6 +59,7 @@
 #include "doomerrors.h"
 #include "v_text.h"
 #include "cmdlib.h"
+#include "threadpool.h"
 #include "g_levellocals.h"
 
 char nulspace[1024 * 1024 * 4];
@@ -223,6 +225,102 @@ struct FJSONObject
 	}
 };
 
+//==========================================================================
+//
+// Binary encoding
+//
+// This is the same token stream the JSON writers get, stored without any
+// text formatting: integers are varints, doubles are their raw 8 bytes and
+// every key name is only spelled out the first time it is used. Afterward
+// it is referenced by its index. The reader turns this back into the same
+// DOM that parsing the JSON would produce, so none of the Serialize
+// functions need to care which format is being used.
+//
+//==========================================================================
+
+static const char BinaryMagic[4] = { 'Z', 'B', 'I', 'N' };
+
+enum EBinaryToken
+{
+	BT_Null,
+	BT_False,
+	BT_True,
+	BT_Int,			// zigzag varint
+	BT_Uint,		// varint
+	BT_Int64,		// zigzag varint
+	BT_Uint64,		// varint
+	BT_Double,		// 8 bytes, little endian
+	BT_String,		// varint length + characters
+	BT_StartObject,
+	BT_EndObject,
+	BT_StartArray,
+	BT_EndArray,
+	BT_NewKey,		// varint length + characters, gets the next key index
+	BT_Key,			// varint key index
+};
+
+//==========================================================================
+//
+// Maps key names to their index in the binary output.
+// Hashed by content because keys are often built in reused buffers.
+//
+//==========================================================================
+
+struct FBinaryKeyTable
+{
+	TArray<FString> Names;
+	TArray<int> Buckets;	// index + 1 into Names, 0 is empty
+
+	int Find(const char *key, size_t len, unsigned hash) const
+	{
+		unsigned mask = Buckets.Size() - 1;
+		for (unsigned i = hash & mask; Buckets[i] != 0; i = (i + 1) & mask)
+		{
+			const FString &name = Names[Buckets[i] - 1];
+			if (name.Len() == len && !memcmp(name.GetChars(), key, len)) return Buckets[i] - 1;
+		}
+		return -1;
+	}
+
+	void Insert(unsigned index, unsigned hash)
+	{
+		unsigned mask = Buckets.Size() - 1;
+		unsigned i = hash & mask;
+		while (Buckets[i] != 0) i = (i + 1) & mask;
+		Buckets[i] = index + 1;
+	}
+
+	// Returns the key's index and whether it was newly added.
+	int Add(const char *key, size_t len, bool &isnew)
+	{
+		if (Buckets.Size() == 0)
+		{
+			Buckets.Resize(256);
+			memset(&Buckets[0], 0, Buckets.Size() * sizeof(int));
+		}
+		unsigned hash = SuperFastHash(key, len);
+		int index = Find(key, len, hash);
+		isnew = index < 0;
+		if (!isnew) return index;
+
+		index = Names.Push(FString(key, len));
+		if (Names.Size() * 2 > Buckets.Size())
+		{
+			Buckets.Resize(Buckets.Size() * 2);
+			memset(&Buckets[0], 0, Buckets.Size() * sizeof(int));
+			for (unsigned i = 0; i < Names.Size(); i++)
+			{
+				Insert(i, SuperFastHash(Names[i].GetChars(), Names[i].Len()));
+			}
+		}
+		else
+		{
+			Insert(index, hash);
+		}
+		return index;
+	}
+};
+
 //==========================================================================
 //
 // some wrapper stuff to keep the RapidJSON dependencies out of the global headers.
@@ -237,21 +335,28 @@ struct FWriter
 
 	Writer *mWriter1;
 	PrettyWriter *mWriter2;
+	bool mBinary;
 	TArray<bool> mInObject;
 	rapidjson::StringBuffer mOutString;
 	TArray<DObject *> mDObjects;
 	TMap<DObject *, int> mObjectMap;
+	FBinaryKeyTable mKeys;
 	
-	FWriter(bool pretty)
+	FWriter(bool pretty, bool binary = false)
 	{
-		if (!pretty)
+		mWriter1 = nullptr;
+		mWriter2 = nullptr;
+		mBinary = binary;
+		if (binary)
+		{
+			memcpy(mOutString.Push(sizeof(BinaryMagic)), BinaryMagic, sizeof(BinaryMagic));
+		}
+		else if (!pretty)
 		{
 			mWriter1 = new Writer(mOutString);
-			mWriter2 = nullptr;
 		}
 		else
 		{
-			mWriter1 = nullptr;
 			mWriter2 = new PrettyWriter(mOutString);
 		}
 	}
@@ -268,40 +373,81 @@ struct FWriter
 		return mInObject.Size() > 0 && mInObject.Last();
 	}
 
+	void PutVarint(uint64_t v)
+	{
+		while (v >= 0x80)
+		{
+			mOutString.Put(char((v & 0x7f) | 0x80));
+			v >>= 7;
+		}
+		mOutString.Put(char(v));
+	}
+
+	void PutToken(EBinaryToken token, int64_t v)
+	{
+		mOutString.Put(char(token));
+		PutVarint((uint64_t(v) << 1) ^ uint64_t(v >> 63));
+	}
+
+	void PutToken(EBinaryToken token, uint64_t v)
+	{
+		mOutString.Put(char(token));
+		PutVarint(v);
+	}
+
+	void PutChars(EBinaryToken token, const char *k, size_t len)
+	{
+		PutToken(token, uint64_t(len));
+		memcpy(mOutString.Push(len), k, len);
+	}
+
 	void StartObject()
 	{
 		if (mWriter1) mWriter1->StartObject();
 		else if (mWriter2) mWriter2->StartObject();
+		else if (mBinary) mOutString.Put(BT_StartObject);
 	}
 
 	void EndObject()
 	{
 		if (mWriter1) mWriter1->EndObject();
 		else if (mWriter2) mWriter2->EndObject();
+		else if (mBinary) mOutString.Put(BT_EndObject);
 	}
 
 	void StartArray()
 	{
 		if (mWriter1) mWriter1->StartArray();
 		else if (mWriter2) mWriter2->StartArray();
+		else if (mBinary) mOutString.Put(BT_StartArray);
 	}
 
 	void EndArray()
 	{
 		if (mWriter1) mWriter1->EndArray();
 		else if (mWriter2) mWriter2->EndArray();
+		else if (mBinary) mOutString.Put(BT_EndArray);
 	}
 
 	void Key(const char *k)
 	{
 		if (mWriter1) mWriter1->Key(k);
 		else if (mWriter2) mWriter2->Key(k);
+		else if (mBinary)
+		{
+			bool isnew;
+			size_t len = strlen(k);
+			int index = mKeys.Add(k, len, isnew);
+			if (isnew) PutChars(BT_NewKey, k, len);
+			else PutToken(BT_Key, uint64_t(index));
+		}
 	}
 
 	void Null()
 	{
 		if (mWriter1) mWriter1->Null();
 		else if (mWriter2) mWriter2->Null();
+		else if (mBinary) mOutString.Put(BT_Null);
 	}
 
 	void String(const char *k)
@@ -309,6 +455,7 @@ struct FWriter
 		k = StringToUnicode(k);
 		if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
+		else if (mBinary) PutChars(BT_String, k, strlen(k));
 	}
 
 	void String(const char *k, int size)
@@ -316,36 +463,42 @@ struct FWriter
 		k = StringToUnicode(k, size);
 		if (mWriter1) mWriter1->String(k);
 		else if (mWriter2) mWriter2->String(k);
+		else if (mBinary) PutChars(BT_String, k, strlen(k));
 	}
 
 	void Bool(bool k)
 	{
 		if (mWriter1) mWriter1->Bool(k);
 		else if (mWriter2) mWriter2->Bool(k);
+		else if (mBinary) mOutString.Put(k ? BT_True : BT_False);
 	}
 
 	void Int(int32_t k)
 	{
 		if (mWriter1) mWriter1->Int(k);
 		else if (mWriter2) mWriter2->Int(k);
+		else if (mBinary) PutToken(BT_Int, int64_t(k));
 	}
 
 	void Int64(int64_t k)
 	{
 		if (mWriter1) mWriter1->Int64(k);
 		else if (mWriter2) mWriter2->Int64(k);
+		else if (mBinary) PutToken(BT_Int64, k);
 	}
 
 	void Uint(uint32_t k)
 	{
 		if (mWriter1) mWriter1->Uint(k);
 		else if (mWriter2) mWriter2->Uint(k);
+		else if (mBinary) PutToken(BT_Uint, uint64_t(k));
 	}
 
 	void Uint64(int64_t k)
 	{
 		if (mWriter1) mWriter1->Uint64(k);
 		else if (mWriter2) mWriter2->Uint64(k);
+		else if (mBinary) PutToken(BT_Uint64, uint64_t(k));
 	}
 
 	void Double(double k)
@@ -358,10 +511,183 @@ struct FWriter
 		{
 			mWriter2->Double(k);
 		}
+		else if (mBinary)
+		{
+			uint64_t bits;
+			memcpy(&bits, &k, sizeof(bits));
+			mOutString.Put(BT_Double);
+			char *p = mOutString.Push(8);
+			for (int i = 0; i < 8; i++) p[i] = char(bits >> (i * 8));
+		}
 	}
 
 };
 
+//==========================================================================
+//
+// Feeds a binary stream into a rapidjson document as SAX events.
+//
+//==========================================================================
+
+class FBinaryReader
+{
+	const uint8_t *mPos, *mEnd;
+	TArray<const char *> mKeyNames;
+	TArray<unsigned> mKeyLengths;
+	rapidjson::Document::AllocatorType &mAllocator;
+
+	struct FContainer
+	{
+		bool IsObject;
+		unsigned Count;
+	};
+
+	bool GetVarint(uint64_t &v)
+	{
+		v = 0;
+		for (int shift = 0; mPos < mEnd && shift < 64; shift += 7)
+		{
+			uint8_t b = *mPos++;
+			v |= uint64_t(b & 0x7f) << shift;
+			if (!(b & 0x80)) return true;
+		}
+		return false;
+	}
+
+	bool GetZigzag(int64_t &v)
+	{
+		uint64_t u;
+		if (!GetVarint(u)) return false;
+		v = int64_t(u >> 1) ^ -int64_t(u & 1);
+		return true;
+	}
+
+	bool GetChars(const char *&chars, uint64_t &len)
+	{
+		if (!GetVarint(len) || len > uint64_t(mEnd - mPos)) return false;
+		chars = (const char *)mPos;
+		mPos += len;
+		return true;
+	}
+
+public:
+	FBinaryReader(const char *buffer, size_t length, rapidjson::Document::AllocatorType &alloc)
+		: mPos((const uint8_t *)buffer + sizeof(BinaryMagic)), mEnd((const uint8_t *)buffer + length), mAllocator(alloc)
+	{
+	}
+
+	template<class Handler>
+	bool operator()(Handler &handler)
+	{
+		TArray<FContainer> stack;
+		const char *chars;
+		uint64_t u;
+		int64_t i;
+
+		while (mPos < mEnd)
+		{
+			int token = *mPos++;
+
+			if (token != BT_EndObject && token != BT_EndArray && stack.Size() > 0)
+			{
+				// Objects count their keys, arrays their values.
+				bool iskey = token == BT_NewKey || token == BT_Key;
+				if (iskey == stack.Last().IsObject) stack.Last().Count++;
+			}
+
+			switch (token)
+			{
+			case BT_Null:
+				handler.Null();
+				break;
+
+			case BT_False:
+			case BT_True:
+				handler.Bool(token == BT_True);
+				break;
+
+			case BT_Int:
+				if (!GetZigzag(i)) return false;
+				handler.Int(int(i));
+				break;
+
+			case BT_Uint:
+				if (!GetVarint(u)) return false;
+				handler.Uint(unsigned(u));
+				break;
+
+			case BT_Int64:
+				if (!GetZigzag(i)) return false;
+				handler.Int64(i);
+				break;
+
+			case BT_Uint64:
+				if (!GetVarint(u)) return false;
+				handler.Uint64(u);
+				break;
+
+			case BT_Double:
+			{
+				if (mEnd - mPos < 8) return false;
+				uint64_t bits = 0;
+				for (int b = 0; b < 8; b++) bits |= uint64_t(mPos[b]) << (b * 8);
+				mPos += 8;
+				double d;
+				memcpy(&d, &bits, sizeof(d));
+				handler.Double(d);
+				break;
+			}
+
+			case BT_String:
+				if (!GetChars(chars, u)) return false;
+				handler.String(chars, rapidjson::SizeType(u), true);
+				break;
+
+			case BT_NewKey:
+			{
+				// Key names are stored once in the document and shared by all members using them.
+				if (!GetChars(chars, u)) return false;
+				char *name = (char *)mAllocator.Malloc(size_t(u) + 1);
+				memcpy(name, chars, size_t(u));
+				name[u] = 0;
+				mKeyNames.Push(name);
+				mKeyLengths.Push(unsigned(u));
+				handler.Key(name, rapidjson::SizeType(u), false);
+				break;
+			}
+
+			case BT_Key:
+				if (!GetVarint(u) || u >= mKeyNames.Size()) return false;
+				handler.Key(mKeyNames[unsigned(u)], mKeyLengths[unsigned(u)], false);
+				break;
+
+			case BT_StartObject:
+			case BT_StartArray:
+				stack.Push({ token == BT_StartObject, 0 });
+				if (token == BT_StartObject) handler.StartObject();
+				else handler.StartArray();
+				break;
+
+			case BT_EndObject:
+			case BT_EndArray:
+			{
+				if (stack.Size() == 0 || stack.Last().IsObject != (token == BT_EndObject)) return false;
+				unsigned count = stack.Last().Count;
+				stack.Pop();
+				if (token == BT_EndObject) handler.EndObject(count);
+				else handler.EndArray(count);
+				if (stack.Size() == 0) return true;
+				break;
+			}
+
+			default:
+				return false;
+			}
+		}
+		return false;
+	}
+};
+
 //==========================================================================
 //
 //
@@ -376,11 +702,30 @@ struct FReader
 	rapidjson::Value *mKeyValue = nullptr;
 	int mPlayers[MAXPLAYERS];
 	bool mObjectsRead = false;
+	bool mParsed = false;
 
 	FReader(const char *buffer, size_t length)
 	{
-		rapidjson::Document doc;
-		mDoc.Parse(buffer, length);
+		if (length >= sizeof(BinaryMagic) && !memcmp(buffer, BinaryMagic, sizeof(BinaryMagic)))
+		{
+			// Populate does not tell whether the generator succeeded.
+			FBinaryReader binary(buffer, length, mDoc.GetAllocator());
+			auto generator = [&](auto &handler) { return mParsed = binary(handler); };
+			mDoc.Populate(generator);
+			if (!mParsed)
+			{
+				Printf(TEXTCOLOR_RED "Binary data is truncated or corrupt\n");
+			}
+		}
+		else
+		{
+			mDoc.Parse(buffer, length);
+			mParsed = !mDoc.HasParseError();
+			if (!mParsed)
+			{
+				Printf(TEXTCOLOR_RED "JSON parse error at offset %u: %s\n", (unsigned)mDoc.GetErrorOffset(), rapidjson::GetParseError_En(mDoc.GetParseError()));
+			}
+		}
 		mObjects.Push(FJSONObject(&mDoc));
 		memset(mPlayers, -1, sizeof(mPlayers));
 	}
@@ -431,6 +776,23 @@ bool FSerializer::OpenWriter(bool pretty)
 	return true;
 }
 
+//==========================================================================
+//
+// Writes the compact binary format. The output can be read back with
+// OpenReader like any JSON output, but is a lot faster to write and parse.
+//
+//==========================================================================
+
+bool FSerializer::OpenBinaryWriter()
+{
+	if (w != nullptr || r != nullptr) return false;
+
+	mErrors = 0;
+	w = new FWriter(false, true);
+	BeginObject(nullptr);
+	return true;
+}
+
 //==========================================================================
 //
 //
@@ -443,6 +805,12 @@ bool FSerializer::OpenReader(const char *buffer, size_t length)
 
 	mErrors = 0;
 	r = new FReader(buffer, length);
+	if (!r->mParsed)
+	{
+		delete r;
+		r = nullptr;
+		return false;
+	}
 	return true;
 }
 
@@ -468,6 +836,12 @@ bool FSerializer::OpenReader(FCompressedBuffer *input)
 		input->Decompress(unpacked.Data());
 		r = new FReader(unpacked.Data(), input->mSize);
 	}
+	if (!r->mParsed)
+	{
+		delete r;
+		r = nullptr;
+		return false;
+	}
 	return true;
 }
 
@@ -1099,22 +1473,19 @@ const char *FSerializer::GetOutput(unsigned *len)
 //
 //==========================================================================
 
-FCompressedBuffer FSerializer::GetCompressedOutput()
+static FCompressedBuffer CompressBuffer(const char *data, unsigned size)
 {
-	if (isReading()) return{ 0,0,0,0,0,nullptr };
 	FCompressedBuffer buff;
-	WriteObjects();
-	EndObject();
-	buff.mSize = (unsigned)w->mOutString.GetSize();
+	buff.mSize = size;
 	buff.mZipFlags = 0;
-	buff.mCRC32 = crc32(0, (const Bytef*)w->mOutString.GetString(), buff.mSize);
+	buff.mCRC32 = crc32(0, (const Bytef*)data, buff.mSize);
 
 	uint8_t *compressbuf = new uint8_t[buff.mSize+1];
 
 	z_stream stream;
 	int err;
 
-	stream.next_in = (Bytef *)w->mOutString.GetString();
+	stream.next_in = (Bytef *)data;
 	stream.avail_in = buff.mSize;
 	stream.next_out = (Bytef*)compressbuf;
 	stream.avail_out = buff.mSize;
@@ -1148,7 +1519,8 @@ FCompressedBuffer FSerializer::GetCompressedOutput()
 	}
 
 error:
-	memcpy(compressbuf, w->mOutString.GetString(), buff.mSize + 1);
+	memcpy(compressbuf, data, buff.mSize + 1);
+	buff.mBuffer = (char*)compressbuf;
 	buff.mCompressedSize = buff.mSize;
 	buff.mMethod = METHOD_STORED;
 	return buff;
@@ -1160,6 +1532,48 @@ error:
 //
 //==========================================================================
 
+FCompressedBuffer FSerializer::GetCompressedOutput()
+{
+	if (isReading()) return{ 0,0,0,0,0,nullptr };
+	WriteObjects();
+	EndObject();
+	return CompressBuffer(w->mOutString.GetString(), (unsigned)w->mOutString.GetSize());
+}
+
+//==========================================================================
+//
+// Finishes the output on the calling thread and hands the writer over to
+// a worker which compresses it. The serializer is closed afterward.
+//
+//==========================================================================
+
+std::future<FCompressedBuffer> FSerializer::GetCompressedOutputAsync()
+{
+	auto promise = std::make_shared<std::promise<FCompressedBuffer>>();
+	if (!isWriting())
+	{
+		promise->set_value({ 0,0,0,0,0,nullptr });
+		return promise->get_future();
+	}
+	WriteObjects();
+	EndObject();
+
+	FWriter *writer = w;
+	w = nullptr;
+	FThreadPool::Instance()->Submit([=]()
+	{
+		promise->set_value(CompressBuffer(writer->mOutString.GetString(), (unsigned)writer->mOutString.GetSize()));
+		delete writer;
+	});
+	return promise->get_future();
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
 FSerializer &Serialize(FSerializer &arc, const char *key, bool &value, bool *defval)
 {
 	if (arc.isWriting())
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <type_traits>
+#include <future>
 #include "tarray.h"
 #include "r_defs.h"
 #include "resourcefiles/file_zip.h"
@@ -78,6 +79,7 @@ public:
 		Close();
 	}
 	bool OpenWriter(bool pretty = true);
+	bool OpenBinaryWriter();
 	bool OpenReader(const char *buffer, size_t length);
 	bool OpenReader(FCompressedBuffer *input);
 	void Close();
@@ -90,6 +92,7 @@ public:
 	const char *GetKey();
 	const char *GetOutput(unsigned *len = nullptr);
 	FCompressedBuffer GetCompressedOutput();
+	std::future<FCompressedBuffer> GetCompressedOutputAsync();	// closes the writer, compression happens on a worker thread.
 	FSerializer &Args(const char *key, int *args, int *defargs, int special);
 	FSerializer &Terrain(const char *key, int &terrain, int *def = nullptr);
 	FSerializer &Sprite(const char *key, int32_t &spritenum, int32_t *def);
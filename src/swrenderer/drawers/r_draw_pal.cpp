@@ -34,7 +34,7 @@
 */
 
 #ifndef NO_SSE
-#include <xmmintrin.h>
+#include <immintrin.h>
 #endif
 #include "templates.h"
 #include "doomtype.h"
@@ -43,12 +43,18 @@
 #include "r_draw.h"
 #include "v_video.h"
 #include "r_draw_pal.h"
+#include "r_draw_rgba.h"
 #include "swrenderer/viewport/r_viewport.h"
 #include "swrenderer/scene/r_light.h"
+#include "x86.h"
+#include "c_dispatch.h"
+#include "c_bench.h"
+#include "v_text.h"
 
 // [SP] r_blendmethod - false = rgb555 matching (ZDoom classic), true = rgb666 (refactored)
 CVAR(Bool, r_blendmethod, false, CVAR_GLOBALCONFIG | CVAR_ARCHIVE)
 EXTERN_CVAR(Int, gl_particles_style)
+EXTERN_CVAR(Bool, r_avx2drawers)
 
 /*
 	[RH] This translucency algorithm is based on DOSDoom 0.65's, but uses
@@ -845,8 +851,15 @@ namespace swrenderer
 
 	/////////////////////////////////////////////////////////////////////////
 
+	// r_avx2drawers is read here, on the thread that queues the command
+	static PalDrawerLoop GetPalDrawerLoop()
+	{
+		return r_avx2drawers && CPU.bAVX2 ? PalDrawerLoop::AVX2 : PalDrawerLoop::Unrolled;
+	}
+
 	PalColumnCommand::PalColumnCommand(const SpriteDrawerArgs &args) : args(args)
 	{
+		_loop = GetPalDrawerLoop();
 	}
 
 	uint8_t PalColumnCommand::AddLights(uint8_t fg, uint8_t material, uint32_t lit_r, uint32_t lit_g, uint32_t lit_b)
@@ -865,6 +878,41 @@ namespace swrenderer
 		return RGB256k.All[((lit_r >> 2) << 12) | ((lit_g >> 2) << 6) | (lit_b >> 2)];
 	}
 
+	// The unlit column loop. The unrolled version does four texel and colormap
+	// lookups that do not depend on each other per step, so that an in-order
+	// CPU such as the ARM cores of a Raspberry Pi can overlap their loads.
+	// Both versions draw exactly the same pixels.
+	template<bool Unrolled>
+	static void DrawColumnPalLoop(uint8_t *dest, int pitch, const uint8_t *source, const uint8_t *colormap, fixed_t frac, fixed_t fracstep, int count)
+	{
+		if (Unrolled)
+		{
+			for (int blocks = count >> 2; blocks > 0; blocks--)
+			{
+				uint8_t p0 = colormap[source[frac >> FRACBITS]];
+				uint8_t p1 = colormap[source[(frac + fracstep) >> FRACBITS]];
+				uint8_t p2 = colormap[source[(frac + fracstep * 2) >> FRACBITS]];
+				uint8_t p3 = colormap[source[(frac + fracstep * 3) >> FRACBITS]];
+				dest[0] = p0;
+				dest[pitch] = p1;
+				dest[pitch * 2] = p2;
+				dest[pitch * 3] = p3;
+
+				dest += pitch * 4;
+				frac += fracstep * 4;
+			}
+			count &= 3;
+		}
+
+		while (count-- > 0)
+		{
+			*dest = colormap[source[frac >> FRACBITS]];
+
+			dest += pitch;
+			frac += fracstep;
+		}
+	}
+
 	void DrawColumnPalCommand::Execute(DrawerThread *thread)
 	{
 		int count;
@@ -900,14 +948,10 @@ namespace swrenderer
 		uint32_t dynlight = args.DynamicLight();
 		if (dynlight == 0)
 		{
-			do
-			{
-				*dest = colormap[source[frac >> FRACBITS]];
-
-				dest += pitch;
-				frac += fracstep;
-
-			} while (--count);
+			if (_loop == PalDrawerLoop::Scalar)
+				DrawColumnPalLoop<false>(dest, pitch, source, colormap, frac, fracstep, count);
+			else
+				DrawColumnPalLoop<true>(dest, pitch, source, colormap, frac, fracstep, count);
 		}
 		else
 		{
@@ -2037,6 +2081,7 @@ namespace swrenderer
 		_num_dynlights = args.dc_num_lights;
 		_viewpos_x = args.dc_viewpos.X;
 		_step_viewpos_x = args.dc_viewpos_step.X;
+		_loop = GetPalDrawerLoop();
 	}
 
 	uint8_t PalSpanCommand::AddLights(const DrawerLight *lights, int num_lights, float viewpos_x, uint8_t fg, uint8_t material)
@@ -2092,6 +2137,136 @@ namespace swrenderer
 		return RGB256k.All[((lit_r >> 2) << 12) | ((lit_g >> 2) << 6) | (lit_b >> 2)];
 	}
 
+#ifndef NO_SSE
+	// Fetches one byte per lane. Each lane loads the aligned dword holding its
+	// byte; that dword never straddles a page, so this cannot fault even when
+	// the byte is the last one of a buffer.
+	AVX2_TARGET static FORCEINLINE __m256i GatherBytesAVX2(const uint8_t *base, __m256i index)
+	{
+		uintptr_t misalign = (uintptr_t)base & 3;
+		const int *aligned = (const int *)(base - misalign);
+		index = _mm256_add_epi32(index, _mm256_set1_epi32((int)misalign));
+		__m256i words = _mm256_i32gather_epi32(aligned, _mm256_srli_epi32(index, 2), 4);
+		__m256i shift = _mm256_slli_epi32(_mm256_and_si256(index, _mm256_set1_epi32(3)), 3);
+		return _mm256_and_si256(_mm256_srlv_epi32(words, shift), _mm256_set1_epi32(0xff));
+	}
+
+	// Draws the unlit span pixels eight at a time and returns how many were
+	// drawn. The caller finishes the remaining count % 8 pixels.
+	template<bool Is64x64, bool Translucent>
+	AVX2_TARGET static int DrawSpanAVX2(uint8_t *dest, const uint8_t *source, const uint8_t *colormap, uint32_t xfrac, uint32_t yfrac, uint32_t xstep, uint32_t ystep, int count, uint32_t srcwidth, uint32_t srcheight, const uint32_t *fg2rgb, const uint32_t *bg2rgb)
+	{
+		__m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		__m256i mxfrac = _mm256_add_epi32(_mm256_set1_epi32(xfrac), _mm256_mullo_epi32(lane, _mm256_set1_epi32(xstep)));
+		__m256i myfrac = _mm256_add_epi32(_mm256_set1_epi32(yfrac), _mm256_mullo_epi32(lane, _mm256_set1_epi32(ystep)));
+		__m256i mxstep = _mm256_set1_epi32(xstep * 8);
+		__m256i mystep = _mm256_set1_epi32(ystep * 8);
+		__m256i mwidth = _mm256_set1_epi32(srcwidth);
+		__m256i mheight = _mm256_set1_epi32(srcheight);
+
+		int blocks = count / 8;
+		for (int i = 0; i < blocks; i++)
+		{
+			__m256i spot;
+			if (Is64x64)
+			{
+				spot = _mm256_add_epi32(_mm256_and_si256(_mm256_srli_epi32(mxfrac, 32 - 6 - 6), _mm256_set1_epi32(63 * 64)), _mm256_srli_epi32(myfrac, 32 - 6));
+			}
+			else
+			{
+				__m256i u = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(mxfrac, 16), mwidth), 16);
+				__m256i v = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(myfrac, 16), mheight), 16);
+				spot = _mm256_add_epi32(_mm256_mullo_epi32(u, mheight), v);
+			}
+
+			__m256i fg = GatherBytesAVX2(colormap, GatherBytesAVX2(source, spot));
+			if (Translucent)
+			{
+				__m256i bg = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)dest));
+				fg = _mm256_i32gather_epi32((const int *)fg2rgb, fg, 4);
+				bg = _mm256_i32gather_epi32((const int *)bg2rgb, bg, 4);
+				fg = _mm256_or_si256(_mm256_add_epi32(fg, bg), _mm256_set1_epi32(0x1f07c1f));
+				fg = GatherBytesAVX2(RGB32k.All, _mm256_and_si256(fg, _mm256_srli_epi32(fg, 15)));
+			}
+
+			__m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(fg, fg), _mm256_setzero_si256());
+			_mm_storel_epi64((__m128i*)dest, _mm_unpacklo_epi32(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1)));
+			dest += 8;
+
+			mxfrac = _mm256_add_epi32(mxfrac, mxstep);
+			myfrac = _mm256_add_epi32(myfrac, mystep);
+		}
+		return blocks * 8;
+	}
+
+#endif
+
+	// Draws the unlit span pixels four at a time and returns how many were
+	// drawn. Like the unrolled column loop the four lookups of a step do not
+	// depend on each other. The caller finishes the remaining count % 4 pixels.
+	template<bool Is64x64, bool Translucent>
+	static int DrawSpanUnrolled(uint8_t *dest, const uint8_t *source, const uint8_t *colormap, uint32_t xfrac, uint32_t yfrac, uint32_t xstep, uint32_t ystep, int count, uint32_t srcwidth, uint32_t srcheight, const uint32_t *fg2rgb, const uint32_t *bg2rgb)
+	{
+		auto sample = [&](int i) -> uint8_t
+		{
+			uint32_t u = xfrac + xstep * i;
+			uint32_t v = yfrac + ystep * i;
+			uint32_t spot;
+			if (Is64x64)
+				spot = ((u >> (32 - 6 - 6)) & (63 * 64)) + (v >> (32 - 6));
+			else
+				spot = (((u >> 16) * srcwidth) >> 16) * srcheight + (((v >> 16) * srcheight) >> 16);
+			uint32_t fg = colormap[source[spot]];
+			if (Translucent)
+			{
+				fg = (fg2rgb[fg] + bg2rgb[dest[i]]) | 0x1f07c1f;
+				fg = RGB32k.All[fg & (fg >> 15)];
+			}
+			return fg;
+		};
+
+		int blocks = count >> 2;
+		for (int i = 0; i < blocks; i++)
+		{
+			uint8_t p0 = sample(0);
+			uint8_t p1 = sample(1);
+			uint8_t p2 = sample(2);
+			uint8_t p3 = sample(3);
+			dest[0] = p0;
+			dest[1] = p1;
+			dest[2] = p2;
+			dest[3] = p3;
+
+			dest += 4;
+			xfrac += xstep * 4;
+			yfrac += ystep * 4;
+		}
+		return blocks * 4;
+	}
+
+	// Runs the AVX2 or unrolled span loop, if selected, and advances the span
+	// past what it drew. Returns true if nothing is left for the scalar loop.
+	template<bool Is64x64, bool Translucent>
+	static bool TryDrawSpanFast(PalDrawerLoop loop, uint8_t *&dest, const uint8_t *source, const uint8_t *colormap, uint32_t &xfrac, uint32_t &yfrac, uint32_t xstep, uint32_t ystep, int &count, uint32_t srcwidth, uint32_t srcheight, const uint32_t *fg2rgb = nullptr, const uint32_t *bg2rgb = nullptr)
+	{
+		int drawn;
+#ifndef NO_SSE
+		if (loop == PalDrawerLoop::AVX2)
+			drawn = DrawSpanAVX2<Is64x64, Translucent>(dest, source, colormap, xfrac, yfrac, xstep, ystep, count, srcwidth, srcheight, fg2rgb, bg2rgb);
+		else
+#endif
+		if (loop == PalDrawerLoop::Unrolled)
+			drawn = DrawSpanUnrolled<Is64x64, Translucent>(dest, source, colormap, xfrac, yfrac, xstep, ystep, count, srcwidth, srcheight, fg2rgb, bg2rgb);
+		else
+			return false;
+
+		dest += drawn;
+		xfrac += drawn * xstep;
+		yfrac += drawn * ystep;
+		count -= drawn;
+		return count == 0;
+	}
+
 	void DrawSpanPalCommand::Execute(DrawerThread *thread)
 	{
 		if (thread->line_skipped_by_thread(_y))
@@ -2124,6 +2299,9 @@ namespace swrenderer
 
 		if (_srcwidth == 64 && _srcheight == 64 && num_dynlights == 0)
 		{
+			if (TryDrawSpanFast<true, false>(_loop, dest, source, colormap, xfrac, yfrac, xstep, ystep, count, 64, 64))
+				return;
+
 			// 64x64 is the most common case by far, so special case it.
 			do
 			{
@@ -2162,6 +2340,9 @@ namespace swrenderer
 			uint32_t srcwidth = _srcwidth;
 			uint32_t srcheight = _srcheight;
 
+			if (num_dynlights == 0 && TryDrawSpanFast<false, false>(_loop, dest, source, colormap, xfrac, yfrac, xstep, ystep, count, srcwidth, srcheight))
+				return;
+
 			do
 			{
 				// Current texture index in u,v.
@@ -2289,6 +2470,9 @@ namespace swrenderer
 		{
 			if (_srcwidth == 64 && _srcheight == 64)
 			{
+				if (num_dynlights == 0 && TryDrawSpanFast<true, true>(_loop, dest, source, colormap, xfrac, yfrac, xstep, ystep, count, 64, 64, fg2rgb, bg2rgb))
+					return;
+
 				// 64x64 is the most common case by far, so special case it.
 				do
 				{
@@ -2309,6 +2493,9 @@ namespace swrenderer
 				uint32_t srcwidth = _srcwidth;
 				uint32_t srcheight = _srcheight;
 
+				if (num_dynlights == 0 && TryDrawSpanFast<false, true>(_loop, dest, source, colormap, xfrac, yfrac, xstep, ystep, count, srcwidth, srcheight, fg2rgb, bg2rgb))
+					return;
+
 				do
 				{
 					spot = (((xfrac >> 16) * srcwidth) >> 16) * srcheight + (((yfrac >> 16) * srcheight) >> 16);
@@ -3166,3 +3353,159 @@ namespace swrenderer
 		}
 	}
 }
+
+//==========================================================================
+//
+// benchpaldrawers
+//
+// Draws the same columns and spans with the scalar, unrolled and (where
+// the CPU has it) AVX2 paletted loops into an offscreen canvas, checks
+// that the output is identical and reports the fill rate of each.
+//
+//==========================================================================
+
+namespace swrenderer
+{
+	template<typename CommandT>
+	class BenchSpanPalCommand : public CommandT
+	{
+	public:
+		BenchSpanPalCommand(const SpanDrawerArgs &args, const uint8_t *source, int width, int height, const uint8_t *colormap, int y, PalDrawerLoop loop) : CommandT(args)
+		{
+			this->_loop = loop;
+			this->_source = source;
+			this->_srcwidth = width;
+			this->_srcheight = height;
+			this->_colormap = colormap;
+			this->_xfrac = y * 0x01234567u;
+			this->_yfrac = y * 0x00abcdefu;
+			this->_xstep = 0x00312345u + y * 0x1000u;
+			this->_ystep = 0x00087654u + y * 0x2000u;
+			this->_srcblend = Col2RGB8[40];
+			this->_destblend = Col2RGB8[24];
+		}
+	};
+
+	struct FPalDrawerBench
+	{
+		enum { Width = 640, Height = 400 };
+
+		DSimpleCanvas Canvas { Width, Height, false };
+		RenderViewport Viewport;
+		DrawerThread Thread;
+		TArray<uint8_t> Texture;
+		TArray<uint8_t> Colormap;
+		TArray<uint8_t> Background;
+		TArray<uint8_t> Result;
+		int Count;
+		bool Mismatch = false;
+
+		FPalDrawerBench(int count) : Count(count)
+		{
+			Viewport.RenderTarget = &Canvas;
+
+			uint32_t seed = 1;
+			auto random = [&]() { seed = seed * 1664525 + 1013904223; return (uint8_t)(seed >> 24); };
+			Texture.Resize(128 * 128);
+			for (auto &texel : Texture) texel = random();
+			Colormap.Resize(256);
+			for (auto &index : Colormap) index = random();
+			Background.Resize(Canvas.GetPitch() * Height);
+			for (auto &pixel : Background) pixel = random();
+		}
+
+		// Times draw(loop) and checks its output against the scalar loop
+		template<typename Func>
+		void Test(const char *name, int texwidth, int texheight, Func draw)
+		{
+			static const PalDrawerLoop loops[] = { PalDrawerLoop::Scalar, PalDrawerLoop::Unrolled, PalDrawerLoop::AVX2 };
+			static const char *const loopnames[] = { "scalar", "unrolled", "AVX2" };
+			int numloops = CPU.bAVX2 ? 3 : 2;
+
+			FString line;
+			line.Format("%-12s %3dx%-3d", name, texwidth, texheight);
+
+			uint64_t scalartime = 0;
+			for (int i = 0; i < numloops; i++)
+			{
+				auto run = [&](int iterations)
+				{
+					memcpy(Canvas.GetPixels(), &Background[0], Background.Size());
+					return C_BenchTime(iterations, [&](int) { draw(loops[i]); });
+				};
+
+				run(1);
+				bool same = true;
+				if (i == 0)
+				{
+					Result.Resize(Background.Size());
+					memcpy(&Result[0], Canvas.GetPixels(), Result.Size());
+				}
+				else
+				{
+					same = memcmp(&Result[0], Canvas.GetPixels(), Result.Size()) == 0;
+					Mismatch |= !same;
+				}
+
+				uint64_t time = run(Count);
+				double mpixels = (double)Width * Height * Count / 1e6;
+				line.AppendFormat("  %s: %7.1f Mpix/s", loopnames[i], time > 0 ? mpixels / (time * 1e-9) : 0.);
+				if (i == 0)
+					scalartime = time;
+				else
+					line.AppendFormat(" %s%s", C_BenchSpeedup(scalartime, time).GetChars(), same ? "" : TEXTCOLOR_RED " mismatch" TEXTCOLOR_NORMAL);
+			}
+			Printf("%s\n", line.GetChars());
+		}
+
+		template<typename CommandT>
+		void TestSpan(const char *name, int texwidth, int texheight)
+		{
+			Test(name, texwidth, texheight, [&](PalDrawerLoop loop)
+			{
+				for (int y = 0; y < Height; y++)
+				{
+					SpanDrawerArgs args;
+					args.SetDestY(&Viewport, y);
+					args.SetDestX1(y % 13);
+					args.SetDestX2(Width - 1 - y % 7);
+					BenchSpanPalCommand<CommandT> command(args, &Texture[0], texwidth, texheight, &Colormap[0], y, loop);
+					command.Execute(&Thread);
+				}
+			});
+		}
+
+		// The column commands only differ in the unlit loop, so time that directly
+		void TestColumn()
+		{
+			Test("column", 128, 128, [&](PalDrawerLoop loop)
+			{
+				int pitch = Canvas.GetPitch();
+				for (int x = 0; x < Width; x++)
+				{
+					if (loop == PalDrawerLoop::Scalar)
+						DrawColumnPalLoop<false>(Canvas.GetPixels() + x, pitch, &Texture[0], &Colormap[0], x * 0x1234, 0x8000 + x * 0x400, Height);
+					else
+						DrawColumnPalLoop<true>(Canvas.GetPixels() + x, pitch, &Texture[0], &Colormap[0], x * 0x1234, 0x8000 + x * 0x400, Height);
+				}
+			});
+		}
+	};
+}
+
+CCMD(benchpaldrawers)
+{
+	using namespace swrenderer;
+
+	int count = C_BenchCount(argv, 1, 10);
+	std::unique_ptr<FPalDrawerBench> bench(new FPalDrawerBench(count));
+	bench->TestColumn();
+	bench->TestSpan<DrawSpanPalCommand>("span", 64, 64);
+	bench->TestSpan<DrawSpanPalCommand>("span", 128, 100);
+	if (!r_blendmethod)
+	{
+		bench->TestSpan<DrawSpanTranslucentPalCommand>("translucent", 64, 64);
+		bench->TestSpan<DrawSpanTranslucentPalCommand>("translucent", 128, 100);
+	}
+	C_BenchCheck(bench->Mismatch, "The paletted drawer loops produced different output!");
+}
@@ -11,6 +11,14 @@
 
 namespace swrenderer
 {
+	// The loop used for the unlit columns and spans, picked when a command is queued
+	enum class PalDrawerLoop
+	{
+		Scalar,		// one pixel at a time
+		Unrolled,	// four independent lookups per step, on any CPU
+		AVX2		// eight pixels at a time with gathers (spans only, columns use Unrolled)
+	};
+
 	class PalWall1Command : public DrawerCommand
 	{
 	public:
@@ -50,6 +58,8 @@ namespace swrenderer
 
 	protected:
 		uint8_t AddLights(uint8_t fg, uint8_t material, uint32_t lit_r, uint32_t lit_g, uint32_t lit_b);
+
+		PalDrawerLoop _loop;
 	};
 
 	class DrawColumnPalCommand : public PalColumnCommand { public: using PalColumnCommand::PalColumnCommand; void Execute(DrawerThread *thread) override; };
@@ -131,6 +141,7 @@ namespace swrenderer
 		int _num_dynlights;
 		float _viewpos_x;
 		float _step_viewpos_x;
+		PalDrawerLoop _loop;
 	};
 
 	class DrawSpanPalCommand : public PalSpanCommand { public: using PalSpanCommand::PalSpanCommand; void Execute(DrawerThread *thread) override; };
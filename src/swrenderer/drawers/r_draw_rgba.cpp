@@ -59,11 +59,16 @@
 #include "r_draw_sprite32_sse2.h"
 #include "r_draw_span32_sse2.h"
 #include "r_draw_sky32_sse2.h"
+#include "r_draw_wall32_avx2.h"
 #endif
 
 #include "gi.h"
 #include "stats.h"
 #include "x86.h"
+#include "c_dispatch.h"
+#include "c_bench.h"
+#include "v_text.h"
+#include "swrenderer/r_swcolormaps.h"
 #include <vector>
 
 // Use linear filtering when scaling up
@@ -78,37 +83,50 @@ CVAR(Bool, r_mipmap, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 // Level of detail texture bias
 CVAR(Float, r_lod_bias, -1.5, 0); // To do: add CVAR_ARCHIVE | CVAR_GLOBALCONFIG when a good default has been decided
 
+// Use the AVX2 drawers if the CPU supports them
+CVAR(Bool, r_avx2drawers, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+
 namespace swrenderer
 {
+#ifndef NO_SSE
+	#define PUSH_WALL_COMMAND(Name) \
+		if (r_avx2drawers && CPU.bAVX2) Queue->Push<Name##AVX2Command>(args); \
+		else Queue->Push<Name##Command>(args)
+#else
+	#define PUSH_WALL_COMMAND(Name) Queue->Push<Name##Command>(args)
+#endif
+
 	void SWTruecolorDrawers::DrawWallColumn(const WallDrawerArgs &args)
 	{
-		Queue->Push<DrawWall32Command>(args);
+		PUSH_WALL_COMMAND(DrawWall32);
 	}
 	
 	void SWTruecolorDrawers::DrawWallMaskedColumn(const WallDrawerArgs &args)
 	{
-		Queue->Push<DrawWallMasked32Command>(args);
+		PUSH_WALL_COMMAND(DrawWallMasked32);
 	}
 	
 	void SWTruecolorDrawers::DrawWallAddColumn(const WallDrawerArgs &args)
 	{
-		Queue->Push<DrawWallAddClamp32Command>(args);
+		PUSH_WALL_COMMAND(DrawWallAddClamp32);
 	}
 	
 	void SWTruecolorDrawers::DrawWallAddClampColumn(const WallDrawerArgs &args)
 	{
-		Queue->Push<DrawWallAddClamp32Command>(args);
+		PUSH_WALL_COMMAND(DrawWallAddClamp32);
 	}
 	
 	void SWTruecolorDrawers::DrawWallSubClampColumn(const WallDrawerArgs &args)
 	{
-		Queue->Push<DrawWallSubClamp32Command>(args);
+		PUSH_WALL_COMMAND(DrawWallSubClamp32);
 	}
 	
 	void SWTruecolorDrawers::DrawWallRevSubClampColumn(const WallDrawerArgs &args)
 	{
-		Queue->Push<DrawWallRevSubClamp32Command>(args);
+		PUSH_WALL_COMMAND(DrawWallRevSubClamp32);
 	}
+
+	#undef PUSH_WALL_COMMAND
 	
 	void SWTruecolorDrawers::DrawColumn(const SpriteDrawerArgs &args)
 	{
@@ -932,3 +950,151 @@ namespace swrenderer
 		}
 	}
 }
+
+#ifndef NO_SSE
+
+//==========================================================================
+//
+// benchwalldrawers
+//
+// Draws the same columns with the SSE2 and AVX2 wall drawers into an
+// offscreen canvas, checks that the output is identical and reports the
+// time each needed.
+//
+//==========================================================================
+
+namespace swrenderer
+{
+	struct FWallDrawerBench
+	{
+		enum { Width = 320, Height = 240, TexHeight = 128 };
+
+		DSimpleCanvas Canvas { Width, Height, true };
+		RenderViewport Viewport;
+		DrawerThread Thread;
+		TArray<uint32_t> Texture;
+		TArray<uint32_t> Background;
+		TArray<uint32_t> Result;
+		DrawerLight Lights[2];
+		int Count;
+		bool Mismatch = false;
+
+		FWallDrawerBench(int count) : Count(count)
+		{
+			Viewport.RenderTarget = &Canvas;
+
+			// Fixed seed so that runs can be compared. Some fully transparent
+			// texels for the masked drawer.
+			uint32_t seed = 1;
+			auto random = [&]() { seed = seed * 1664525 + 1013904223; return seed; };
+			Texture.Resize(TexHeight * 2);
+			for (auto &texel : Texture) texel = (random() & 7) == 0 ? 0 : random();
+			Background.Resize(Canvas.GetPitch() * Height);
+			for (auto &pixel : Background) pixel = random() | 0xff000000;
+
+			Lights[0] = { 0xffc08040, 4000.0f, 0.0f, 30.0f, 256.0f / 200.0f };
+			Lights[1] = { 0xff4080ff, 2500.0f, 0.7f, 90.0f, 256.0f / 150.0f };
+		}
+
+		WallDrawerArgs ColumnArgs(int x, FSWColormap *colormap, bool linear, fixed_t alpha)
+		{
+			WallDrawerArgs args;
+			args.SetStyle(false, false, alpha, &NormalLight);
+			args.SetDest(&Viewport, x, 0);
+			args.SetCount(Height - (x & 3));
+			args.SetTexture((const uint8_t*)&Texture[0], linear ? (const uint8_t*)&Texture[TexHeight] : nullptr, TexHeight);
+			args.SetTextureUPos(x & 15);
+			args.SetTextureVPos(x << 12);
+			args.SetTextureVStep((FRACUNIT / 2) + (x << 8));
+			args.SetBaseColormap(colormap);
+			args.SetLight(0.0f, (x % NUMCOLORMAPS) << FRACBITS);
+			args.dc_viewpos.Z = x * 0.25f;
+			args.dc_viewpos_step.Z = 0.5f;
+			if (x & 1)
+			{
+				args.dc_lights = Lights;
+				args.dc_num_lights = 2;
+			}
+			return args;
+		}
+
+		template<typename CommandT>
+		uint64_t Run(const TArray<WallDrawerArgs> &columns, int iterations)
+		{
+			memcpy(Canvas.GetPixels(), &Background[0], Background.Size() * sizeof(uint32_t));
+			return C_BenchTime(iterations, [&](int)
+			{
+				for (auto &args : columns)
+				{
+					CommandT command(args);
+					command.Execute(&Thread);
+				}
+			});
+		}
+
+		template<typename SSE2CommandT, typename AVX2CommandT>
+		void Test(const char *name, fixed_t alpha)
+		{
+			static const char *const shadenames[] = { "simple", "advanced" };
+			static const char *const filternames[] = { "nearest", "linear" };
+
+			FSWColormap advanced = NormalLight;
+			advanced.Color = PalEntry(255, 200, 180, 120);
+			advanced.Fade = PalEntry(255, 20, 40, 60);
+			advanced.Desaturate = 100;
+
+			for (int shade = 0; shade < 2; shade++)
+			{
+				for (int linear = 0; linear < 2; linear++)
+				{
+					TArray<WallDrawerArgs> columns;
+					for (int x = 0; x < Width; x++)
+					{
+						columns.Push(ColumnArgs(x, shade ? &advanced : &NormalLight, !!linear, alpha));
+					}
+
+					// One pass each from the same background for the compare
+					Run<SSE2CommandT>(columns, 1);
+					Result.Resize(Background.Size());
+					memcpy(&Result[0], Canvas.GetPixels(), Result.Size() * sizeof(uint32_t));
+					Run<AVX2CommandT>(columns, 1);
+					bool same = memcmp(&Result[0], Canvas.GetPixels(), Result.Size() * sizeof(uint32_t)) == 0;
+					Mismatch |= !same;
+
+					uint64_t times[2];
+					times[0] = Run<SSE2CommandT>(columns, Count);
+					times[1] = Run<AVX2CommandT>(columns, Count);
+
+					double mpixels = (double)Width * Height * Count / 1e6;
+					Printf("%-12s %-8s %-7s  SSE2: %7.3f ms  AVX2: %7.3f ms  %6.1f Mpix/s %s%s\n",
+						name, shadenames[shade], filternames[linear],
+						times[0] * 1e-6 / Count, times[1] * 1e-6 / Count,
+						times[1] > 0 ? mpixels / (times[1] * 1e-9) : 0., C_BenchSpeedup(times[0], times[1]).GetChars(),
+						same ? "" : TEXTCOLOR_RED " mismatch");
+				}
+			}
+		}
+	};
+}
+
+CCMD(benchwalldrawers)
+{
+	using namespace swrenderer;
+
+	if (!CPU.bAVX2)
+	{
+		Printf("This CPU does not support AVX2\n");
+		return;
+	}
+
+	int count = C_BenchCount(argv, 1, 10);
+	std::unique_ptr<FWallDrawerBench> bench(new FWallDrawerBench(count));
+	bench->Test<DrawWall32Command, DrawWall32AVX2Command>("opaque", OPAQUE);
+	bench->Test<DrawWallMasked32Command, DrawWallMasked32AVX2Command>("masked", OPAQUE);
+	bench->Test<DrawWallAddClamp32Command, DrawWallAddClamp32AVX2Command>("addclamp", OPAQUE / 2);
+	bench->Test<DrawWallSubClamp32Command, DrawWallSubClamp32AVX2Command>("subclamp", OPAQUE / 2);
+	bench->Test<DrawWallRevSubClamp32Command, DrawWallRevSubClamp32AVX2Command>("revsubclamp", OPAQUE / 2);
+	C_BenchCheck(bench->Mismatch, "AVX2 and SSE2 wall drawers produced different output!");
+}
+
+#endif
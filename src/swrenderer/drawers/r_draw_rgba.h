@@ -70,6 +70,14 @@ namespace swrenderer
 	#define VECTORCALL
 	#endif
 
+	// Lets a function use AVX2 without compiling the whole file with it. Only call
+	// such functions after checking CPU.bAVX2.
+	#if defined(__GNUC__)
+	#define AVX2_TARGET __attribute__((target("avx2")))
+	#else
+	#define AVX2_TARGET
+	#endif
+
 	class DrawFuzzColumnRGBACommand : public DrawerCommand
 	{
 		int _x;
@@ -0,0 +1,356 @@
+/*
+**  Drawer commands for walls, AVX2 version
+**  Copyright (c) 2016 Magnus Norddahl
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+*/
+
+#pragma once
+
+#include "swrenderer/drawers/r_draw_rgba.h"
+#include "swrenderer/drawers/r_draw_wall32_sse2.h"
+#include "swrenderer/viewport/r_walldrawer.h"
+
+namespace swrenderer
+{
+	// Same as DrawWall32T, but shades and blends four pixels per iteration.
+	// The output is identical to the SSE2 version, which is why the light
+	// positions are stepped in pairs exactly like it does.
+	template<typename BlendT>
+	class DrawWall32AVX2T : public DrawerCommand
+	{
+	protected:
+		WallDrawerArgs args;
+
+	public:
+		DrawWall32AVX2T(const WallDrawerArgs &drawerargs) : args(drawerargs) { }
+
+		AVX2_TARGET void Execute(DrawerThread *thread) override
+		{
+			using namespace DrawWall32TModes;
+
+			const uint32_t *source2 = (const uint32_t*)args.TexturePixels2();
+			bool is_nearest_filter = (source2 == nullptr);
+			auto shade_constants = args.ColormapConstants();
+			if (shade_constants.simple_shade)
+			{
+				if (is_nearest_filter)
+					Loop<SimpleShade, NearestFilter>(thread, shade_constants);
+				else
+					Loop<SimpleShade, LinearFilter>(thread, shade_constants);
+			}
+			else
+			{
+				if (is_nearest_filter)
+					Loop<AdvancedShade, NearestFilter>(thread, shade_constants);
+				else
+					Loop<AdvancedShade, LinearFilter>(thread, shade_constants);
+			}
+		}
+
+		template<typename ShadeModeT, typename FilterModeT>
+		AVX2_TARGET FORCEINLINE void VECTORCALL Loop(DrawerThread *thread, ShadeConstants shade_constants)
+		{
+			using namespace DrawWall32TModes;
+
+			const uint32_t *source = (const uint32_t*)args.TexturePixels();
+			const uint32_t *source2 = (const uint32_t*)args.TexturePixels2();
+			int textureheight = args.TextureHeight();
+			uint32_t one = ((0x80000000 + textureheight - 1) / textureheight) * 2 + 1;
+
+			// Shade constants
+			int light = 256 - (args.Light() >> (FRACBITS - 8));
+			__m256i mlight = _mm256_set_epi16(256, light, light, light, 256, light, light, light, 256, light, light, light, 256, light, light, light);
+
+			__m256i inv_desaturate, shade_fade, shade_light;
+			int desaturate;
+			if (ShadeModeT::Mode == (int)ShadeMode::Advanced)
+			{
+				int inv_light = 256 - light;
+				int inv_desat = 256 - shade_constants.desaturate;
+				inv_desaturate = _mm256_setr_epi16(256, inv_desat, inv_desat, inv_desat, 256, inv_desat, inv_desat, inv_desat, 256, inv_desat, inv_desat, inv_desat, 256, inv_desat, inv_desat, inv_desat);
+				shade_fade = _mm256_set1_epi64x(((int64_t)shade_constants.fade_alpha << 48) | ((int64_t)shade_constants.fade_red << 32) | (shade_constants.fade_green << 16) | shade_constants.fade_blue);
+				shade_fade = _mm256_mullo_epi16(shade_fade, _mm256_set_epi16(0, inv_light, inv_light, inv_light, 0, inv_light, inv_light, inv_light, 0, inv_light, inv_light, inv_light, 0, inv_light, inv_light, inv_light));
+				shade_light = _mm256_set1_epi64x(((int64_t)shade_constants.light_alpha << 48) | ((int64_t)shade_constants.light_red << 32) | (shade_constants.light_green << 16) | shade_constants.light_blue);
+				desaturate = shade_constants.desaturate;
+			}
+			else
+			{
+				inv_desaturate = _mm256_setzero_si256();
+				shade_fade = _mm256_setzero_si256();
+				shade_light = _mm256_setzero_si256();
+				desaturate = 0;
+			}
+
+			int count = args.Count();
+			int pitch = args.Viewport()->RenderTarget->GetPitch();
+			uint32_t fracstep = args.TextureVStep();
+			uint32_t frac = args.TextureVPos();
+			uint32_t texturefracx = args.TextureUPos();
+			uint32_t *dest = (uint32_t*)args.Dest();
+			int dest_y = args.DestY();
+
+			auto lights = args.dc_lights;
+			auto num_lights = args.dc_num_lights;
+			float vpz = args.dc_viewpos.Z + args.dc_viewpos_step.Z * thread->skipped_by_thread(dest_y);
+			float stepvpz = args.dc_viewpos_step.Z * thread->num_cores;
+			__m128 viewpos_z = _mm_setr_ps(vpz, vpz + stepvpz, 0.0f, 0.0f);
+			__m128 step_viewpos_z = _mm_set1_ps(stepvpz * 2.0f);
+
+			count = thread->count_for_thread(dest_y, count);
+			if (count <= 0) return;
+			frac += thread->skipped_by_thread(dest_y) * fracstep;
+			dest = thread->dest_for_thread(dest_y, pitch, dest);
+			fracstep *= thread->num_cores;
+			pitch *= thread->num_cores;
+
+			if (FilterModeT::Mode == (int)FilterModes::Linear)
+			{
+				frac -= one / 2;
+			}
+
+			uint32_t srcalpha = args.SrcAlpha() >> (FRACBITS - 8);
+			uint32_t destalpha = args.DestAlpha() >> (FRACBITS - 8);
+
+			int index = 0;
+			for (; index + 4 <= count; index += 4)
+			{
+				uint32_t *d = dest + index * pitch;
+
+				uint32_t ifgcolor[4];
+				for (int i = 0; i < 4; i++)
+				{
+					ifgcolor[i] = DrawWall32T<BlendT>::template Sample<FilterModeT>(frac, source, source2, textureheight, one, texturefracx);
+					frac += fracstep;
+				}
+
+				__m128i bgcolor;
+				if (BlendT::Mode != (int)WallBlendModes::Opaque)
+					bgcolor = _mm_setr_epi32(d[0], d[pitch], d[pitch * 2], d[pitch * 3]);
+				else
+					bgcolor = _mm_setzero_si128();
+
+				__m128i fgcolor = _mm_setr_epi32(ifgcolor[0], ifgcolor[1], ifgcolor[2], ifgcolor[3]);
+				__m128i outcolor = DrawPixels<ShadeModeT>(fgcolor, bgcolor, ifgcolor, viewpos_z, step_viewpos_z, mlight, desaturate, inv_desaturate, shade_fade, shade_light, lights, num_lights, srcalpha, destalpha);
+
+				d[0] = _mm_cvtsi128_si32(outcolor);
+				d[pitch] = _mm_extract_epi32(outcolor, 1);
+				d[pitch * 2] = _mm_extract_epi32(outcolor, 2);
+				d[pitch * 3] = _mm_extract_epi32(outcolor, 3);
+			}
+
+			if (index < count)
+			{
+				int pixels = count - index;
+				uint32_t *d = dest + index * pitch;
+
+				uint32_t desttmp[4] = { 0, 0, 0, 0 };
+				uint32_t ifgcolor[4] = { 0, 0, 0, 0 };
+				for (int i = 0; i < pixels; i++)
+				{
+					if (BlendT::Mode != (int)WallBlendModes::Opaque)
+						desttmp[i] = d[i * pitch];
+					ifgcolor[i] = DrawWall32T<BlendT>::template Sample<FilterModeT>(frac, source, source2, textureheight, one, texturefracx);
+					frac += fracstep;
+				}
+
+				__m128i bgcolor = _mm_loadu_si128((__m128i*)desttmp);
+				__m128i fgcolor = _mm_loadu_si128((__m128i*)ifgcolor);
+				__m128i outcolor = DrawPixels<ShadeModeT>(fgcolor, bgcolor, ifgcolor, viewpos_z, step_viewpos_z, mlight, desaturate, inv_desaturate, shade_fade, shade_light, lights, num_lights, srcalpha, destalpha);
+
+				_mm_storeu_si128((__m128i*)desttmp, outcolor);
+				for (int i = 0; i < pixels; i++)
+				{
+					d[i * pitch] = desttmp[i];
+				}
+			}
+		}
+
+		// Shades and blends four pixels
+		template<typename ShadeModeT>
+		AVX2_TARGET FORCEINLINE __m128i VECTORCALL DrawPixels(__m128i fgcolor, __m128i bgcolor, const uint32_t *ifgcolor, __m128 &viewpos_z, __m128 step_viewpos_z, __m256i mlight, int desaturate, __m256i inv_desaturate, __m256i shade_fade, __m256i shade_light, const DrawerLight *lights, int num_lights, uint32_t srcalpha, uint32_t destalpha)
+		{
+			// The SSE2 drawer steps both of its positions by two pixels each iteration
+			__m128 viewpos_z2 = _mm_add_ps(viewpos_z, step_viewpos_z);
+			__m128 viewpos_z4 = _mm_movelh_ps(viewpos_z, viewpos_z2);
+			viewpos_z = _mm_add_ps(viewpos_z2, step_viewpos_z);
+
+			__m256i fgcolor16 = _mm256_cvtepu8_epi16(fgcolor);
+			__m256i bgcolor16 = _mm256_cvtepu8_epi16(bgcolor);
+			fgcolor16 = Shade<ShadeModeT>(fgcolor16, mlight, ifgcolor, desaturate, inv_desaturate, shade_fade, shade_light, lights, num_lights, viewpos_z4);
+			return Blend(fgcolor16, bgcolor16, ifgcolor, srcalpha, destalpha);
+		}
+
+		template<typename ShadeModeT>
+		AVX2_TARGET FORCEINLINE __m256i VECTORCALL Shade(__m256i fgcolor, __m256i mlight, const uint32_t *ifgcolor, int desaturate, __m256i inv_desaturate, __m256i shade_fade, __m256i shade_light, const DrawerLight *lights, int num_lights, __m128 viewpos_z)
+		{
+			using namespace DrawWall32TModes;
+
+			__m256i material = fgcolor;
+			if (ShadeModeT::Mode == (int)ShadeMode::Simple)
+			{
+				fgcolor = _mm256_srli_epi16(_mm256_mullo_epi16(fgcolor, mlight), 8);
+			}
+			else
+			{
+				int intensity[4];
+				for (int i = 0; i < 4; i++)
+				{
+					intensity[i] = ((RPART(ifgcolor[i]) * 77 + GPART(ifgcolor[i]) * 143 + BPART(ifgcolor[i]) * 37) >> 8) * desaturate;
+				}
+
+				__m256i mintensity = _mm256_set_epi16(
+					0, intensity[3], intensity[3], intensity[3], 0, intensity[2], intensity[2], intensity[2],
+					0, intensity[1], intensity[1], intensity[1], 0, intensity[0], intensity[0], intensity[0]);
+
+				fgcolor = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(fgcolor, inv_desaturate), mintensity), 8);
+				fgcolor = _mm256_mullo_epi16(fgcolor, mlight);
+				fgcolor = _mm256_srli_epi16(_mm256_add_epi16(shade_fade, fgcolor), 8);
+				fgcolor = _mm256_srli_epi16(_mm256_mullo_epi16(fgcolor, shade_light), 8);
+			}
+
+			return AddLights(material, fgcolor, lights, num_lights, viewpos_z);
+		}
+
+		AVX2_TARGET FORCEINLINE __m256i VECTORCALL AddLights(__m256i material, __m256i fgcolor, const DrawerLight *lights, int num_lights, __m128 viewpos_z)
+		{
+			__m256i lit = _mm256_setzero_si256();
+
+			for (int i = 0; i != num_lights; i++)
+			{
+				__m128 light_x = _mm_set1_ps(lights[i].x);
+				__m128 light_y = _mm_set1_ps(lights[i].y);
+				__m128 light_z = _mm_set1_ps(lights[i].z);
+				__m128 light_radius = _mm_set1_ps(lights[i].radius);
+				__m128 m256 = _mm_set1_ps(256.0f);
+
+				// L = light-pos
+				// dist = sqrt(dot(L, L))
+				// distance_attenuation = 1 - MIN(dist * (1/radius), 1)
+				__m128 Lxy2 = light_x; // L.x*L.x + L.y*L.y
+				__m128 Lz = _mm_sub_ps(light_z, viewpos_z);
+				__m128 dist2 = _mm_add_ps(Lxy2, _mm_mul_ps(Lz, Lz));
+				__m128 rcp_dist = _mm_rsqrt_ps(dist2);
+				__m128 dist = _mm_mul_ps(dist2, rcp_dist);
+				__m128 distance_attenuation = _mm_sub_ps(m256, _mm_min_ps(_mm_mul_ps(dist, light_radius), m256));
+
+				// The simple light type
+				__m128 simple_attenuation = distance_attenuation;
+
+				// The point light type
+				// diffuse = dot(N,L) * attenuation
+				__m128 point_attenuation = _mm_mul_ps(_mm_mul_ps(light_y, rcp_dist), distance_attenuation);
+
+				__m128 is_attenuated = _mm_cmpeq_ps(light_y, _mm_setzero_ps());
+				__m128i attenuation = _mm_cvtps_epi32(_mm_or_ps(_mm_and_ps(is_attenuated, simple_attenuation), _mm_andnot_ps(is_attenuated, point_attenuation)));
+
+				// Spread each pixel's attenuation over its four channels
+				__m256i attenuation4 = _mm256_permutevar8x32_epi32(_mm256_castsi128_si256(attenuation), _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3));
+				attenuation4 = _mm256_packs_epi32(attenuation4, attenuation4);
+				attenuation4 = _mm256_shuffle_epi32(attenuation4, _MM_SHUFFLE(1, 1, 0, 0));
+
+				__m256i light_color = _mm256_broadcastq_epi64(_mm_unpacklo_epi8(_mm_cvtsi32_si128(lights[i].color), _mm_setzero_si128()));
+
+				lit = _mm256_add_epi16(lit, _mm256_srli_epi16(_mm256_mullo_epi16(light_color, attenuation4), 8));
+			}
+
+			lit = _mm256_min_epi16(lit, _mm256_set1_epi16(256));
+
+			fgcolor = _mm256_add_epi16(fgcolor, _mm256_srli_epi16(_mm256_mullo_epi16(material, lit), 8));
+			fgcolor = _mm256_min_epi16(fgcolor, _mm256_set1_epi16(255));
+			return fgcolor;
+		}
+
+		// Packs the four pixels back into 8 bits per channel
+		AVX2_TARGET FORCEINLINE __m128i VECTORCALL Pack(__m256i color)
+		{
+			color = _mm256_packus_epi16(color, _mm256_setzero_si256());
+			color = _mm256_permute4x64_epi64(color, _MM_SHUFFLE(3, 1, 2, 0));
+			return _mm_or_si128(_mm256_castsi256_si128(color), _mm_set1_epi32(0xff000000));
+		}
+
+		AVX2_TARGET FORCEINLINE __m128i VECTORCALL Blend(__m256i fgcolor, __m256i bgcolor, const uint32_t *ifgcolor, uint32_t srcalpha, uint32_t destalpha)
+		{
+			using namespace DrawWall32TModes;
+
+			if (BlendT::Mode == (int)WallBlendModes::Opaque)
+			{
+				return Pack(fgcolor);
+			}
+			else if (BlendT::Mode == (int)WallBlendModes::Masked)
+			{
+				__m256i mask = _mm256_cmpeq_epi64(fgcolor, _mm256_setzero_si256());
+				return Pack(_mm256_or_si256(_mm256_and_si256(mask, bgcolor), _mm256_andnot_si256(mask, fgcolor)));
+			}
+			else
+			{
+				int fgalpha[4], bgalpha[4];
+				for (int i = 0; i < 4; i++)
+				{
+					uint32_t alpha = APART(ifgcolor[i]);
+					alpha += alpha >> 7; // 255->256
+					uint32_t inv_alpha = 256 - alpha;
+					bgalpha[i] = (destalpha * alpha + (inv_alpha << 8) + 128) >> 8;
+					fgalpha[i] = (srcalpha * alpha + 128) >> 8;
+				}
+
+				__m256i mbgalpha = _mm256_set_epi16(
+					bgalpha[3], bgalpha[3], bgalpha[3], bgalpha[3], bgalpha[2], bgalpha[2], bgalpha[2], bgalpha[2],
+					bgalpha[1], bgalpha[1], bgalpha[1], bgalpha[1], bgalpha[0], bgalpha[0], bgalpha[0], bgalpha[0]);
+				__m256i mfgalpha = _mm256_set_epi16(
+					fgalpha[3], fgalpha[3], fgalpha[3], fgalpha[3], fgalpha[2], fgalpha[2], fgalpha[2], fgalpha[2],
+					fgalpha[1], fgalpha[1], fgalpha[1], fgalpha[1], fgalpha[0], fgalpha[0], fgalpha[0], fgalpha[0]);
+
+				fgcolor = _mm256_mullo_epi16(fgcolor, mfgalpha);
+				bgcolor = _mm256_mullo_epi16(bgcolor, mbgalpha);
+
+				__m256i fg_lo = _mm256_unpacklo_epi16(fgcolor, _mm256_setzero_si256());
+				__m256i bg_lo = _mm256_unpacklo_epi16(bgcolor, _mm256_setzero_si256());
+				__m256i fg_hi = _mm256_unpackhi_epi16(fgcolor, _mm256_setzero_si256());
+				__m256i bg_hi = _mm256_unpackhi_epi16(bgcolor, _mm256_setzero_si256());
+
+				__m256i out_lo, out_hi;
+				if (BlendT::Mode == (int)WallBlendModes::AddClamp)
+				{
+					out_lo = _mm256_add_epi32(fg_lo, bg_lo);
+					out_hi = _mm256_add_epi32(fg_hi, bg_hi);
+				}
+				else if (BlendT::Mode == (int)WallBlendModes::SubClamp)
+				{
+					out_lo = _mm256_sub_epi32(fg_lo, bg_lo);
+					out_hi = _mm256_sub_epi32(fg_hi, bg_hi);
+				}
+				else if (BlendT::Mode == (int)WallBlendModes::RevSubClamp)
+				{
+					out_lo = _mm256_sub_epi32(bg_lo, fg_lo);
+					out_hi = _mm256_sub_epi32(bg_hi, fg_hi);
+				}
+
+				out_lo = _mm256_srai_epi32(out_lo, 8);
+				out_hi = _mm256_srai_epi32(out_hi, 8);
+				return Pack(_mm256_packs_epi32(out_lo, out_hi));
+			}
+		}
+	};
+
+	typedef DrawWall32AVX2T<DrawWall32TModes::OpaqueWall> DrawWall32AVX2Command;
+	typedef DrawWall32AVX2T<DrawWall32TModes::MaskedWall> DrawWallMasked32AVX2Command;
+	typedef DrawWall32AVX2T<DrawWall32TModes::AddClampWall> DrawWallAddClamp32AVX2Command;
+	typedef DrawWall32AVX2T<DrawWall32TModes::SubClampWall> DrawWallSubClamp32AVX2Command;
+	typedef DrawWall32AVX2T<DrawWall32TModes::RevSubClampWall> DrawWallRevSubClamp32AVX2Command;
+}
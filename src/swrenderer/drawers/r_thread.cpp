@@ -33,8 +33,16 @@
 #include "r_thread.h"
 #include "swrenderer/r_memory.h"
 #include "swrenderer/r_renderthread.h"
+#include "polyrenderer/drawers/poly_triangle.h"
+#include "threadpool.h"
+#include "i_time.h"
+#include "stats.h"
 #include <chrono>
 
+#ifndef NO_SSE
+#include <emmintrin.h>
+#endif
+
 #ifdef WIN32
 void PeekThreadedErrorPane();
 #endif
@@ -44,6 +52,26 @@ CVAR(Int, r_debug_draw, 0, 0);
 
 /////////////////////////////////////////////////////////////////////////////
 
+// Most waits for the drawer bands are shorter than a sleep and wake up
+// round trip, so spin for a while before the caller blocks.
+template<typename Pred>
+static bool SpinUntil(Pred pred)
+{
+	for (int i = 0; i < 4000; i++)
+	{
+		if (pred())
+			return true;
+#ifndef NO_SSE
+		_mm_pause();
+#else
+		std::this_thread::yield();
+#endif
+	}
+	return pred();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 DrawerThreads *DrawerThreads::Instance()
 {
 	static DrawerThreads threads;
@@ -52,11 +80,11 @@ DrawerThreads *DrawerThreads::Instance()
 
 DrawerThreads::DrawerThreads()
 {
+	SetupBands();
 }
 
 DrawerThreads::~DrawerThreads()
 {
-	StopThreads();
 }
 
 void DrawerThreads::Execute(DrawerCommandQueuePtr commands)
@@ -66,25 +94,39 @@ void DrawerThreads::Execute(DrawerCommandQueuePtr commands)
 	
 	auto queue = Instance();
 
-	queue->StartThreads();
-
-	// Add to queue and awaken worker threads
-	std::unique_lock<std::mutex> start_lock(queue->start_mutex);
-	std::unique_lock<std::mutex> end_lock(queue->end_mutex);
-	queue->active_commands.push_back(commands);
-	queue->tasks_left += queue->threads.size();
-	end_lock.unlock();
-	start_lock.unlock();
-	queue->start_condition.notify_all();
+	// Add to the active lists
+	commands->active_self = commands;
+	DrawerCommandQueue *head = queue->active_commands.load();
+	do
+	{
+		commands->active_next = head;
+	} while (!queue->active_commands.compare_exchange_weak(head, commands.get()));
+	queue->tasks_left += (int)queue->bands.size();
+
+	// Queue the list on every band. An idle band gets a task to work through its
+	// queue, a busy one picks the list up once it is done with the earlier ones.
+	FThreadPool *pool = FThreadPool::Instance();
+	for (auto &entry : queue->bands)
+	{
+		DrawerBand *band = entry.get();
+		std::unique_lock<std::mutex> lock(band->mutex);
+		band->pending.push_back(commands);
+		bool start = !band->running;
+		band->running = true;
+		lock.unlock();
+
+		if (start)
+			pool->Submit([=]() { queue->RunBand(band); }, TaskGroup());
+	}
 }
 
 void DrawerThreads::ResetDebugDrawPos()
 {
 	auto queue = Instance();
-	std::unique_lock<std::mutex> start_lock(queue->start_mutex);
 	bool reached_end = false;
-	for (auto &thread : queue->threads)
+	for (auto &band : queue->bands)
 	{
+		DrawerThread &thread = band->thread;
 		if (thread.debug_draw_pos + r_debug_draw * 60 * 2 < queue->debug_draw_end)
 			reached_end = true;
 		thread.debug_draw_pos = 0;
@@ -101,8 +143,7 @@ void DrawerThreads::WaitForWorkers()
 
 	// Wait for workers to finish
 	auto queue = Instance();
-	std::unique_lock<std::mutex> end_lock(queue->end_mutex);
-	if (!queue->end_condition.wait_for(end_lock, 5s, [&]() { return queue->tasks_left == 0; }))
+	if (!queue->WaitForTasks(5s))
 	{
 #ifdef WIN32
 		PeekThreadedErrorPane();
@@ -111,141 +152,152 @@ void DrawerThreads::WaitForWorkers()
 		int *threadCrashed = nullptr;
 		*threadCrashed = 0xdeadbeef;
 	}
-	end_lock.unlock();
 
 	// Clean up
-	std::unique_lock<std::mutex> start_lock(queue->start_mutex);
-	for (auto &thread : queue->threads)
-		thread.current_queue = 0;
-
-	for (auto &list : queue->active_commands)
+	DrawerCommandQueue *list = queue->active_commands.exchange(nullptr);
+	while (list)
 	{
 		for (auto &command : list->commands)
 			command->~DrawerCommand();
 		list->Clear();
+
+		DrawerCommandQueue *next = list->active_next;
+		list->active_next = nullptr;
+		DrawerCommandQueuePtr self = std::move(list->active_self);
+		list = next;
 	}
-	queue->active_commands.clear();
+
+	// Nothing is running, so this is the place to pick up a changed r_multithreaded
+	queue->SetupBands();
 }
 
-void DrawerThreads::WorkerMain(DrawerThread *thread)
+bool DrawerThreads::WaitForTasks(std::chrono::milliseconds timeout)
 {
-	while (true)
-	{
-		// Wait until we are signalled to run:
-		std::unique_lock<std::mutex> start_lock(start_mutex);
-		start_condition.wait(start_lock, [&]() { return thread->current_queue < active_commands.size() || shutdown_flag; });
-		if (shutdown_flag)
-			break;
+	if (SpinUntil([&]() { return tasks_left == 0; }))
+		return true;
 
-		// Grab the commands
-		DrawerCommandQueuePtr list = active_commands[thread->current_queue];
-		thread->current_queue++;
-		thread->numa_start_y = thread->numa_node * screen->GetHeight() / thread->num_numa_nodes;
-		thread->numa_end_y = (thread->numa_node + 1) * screen->GetHeight() / thread->num_numa_nodes;
-		if (thread->poly)
-		{
-			thread->poly->numa_start_y = thread->numa_start_y;
-			thread->poly->numa_end_y = thread->numa_end_y;
-		}
-		start_lock.unlock();
+	std::unique_lock<std::mutex> end_lock(end_mutex);
+	return end_condition.wait_for(end_lock, timeout, [&]() { return tasks_left == 0; });
+}
 
-		// Do the work:
-		if (r_debug_draw)
-		{
-			for (auto& command : list->commands)
-			{
-				thread->debug_draw_pos++;
-				if (thread->debug_draw_pos < debug_draw_end)
-					command->Execute(thread);
-			}
-		}
-		else
-		{
-			for (auto& command : list->commands)
-			{
-				command->Execute(thread);
-			}
-		}
+FString DrawerThreads::GetStats()
+{
+	auto queue = Instance();
+	uint64_t now = I_nsTime();
+	double elapsed = (double)(now - queue->stats_time);
+	queue->stats_time = now;
 
-		// Notify main thread that we finished:
-		std::unique_lock<std::mutex> end_lock(end_mutex);
-		tasks_left--;
-		bool finishedTasks = tasks_left == 0;
-		end_lock.unlock();
-		if (finishedTasks)
-			end_condition.notify_all();
+	FString out, busyList;
+	double busy = 0.0;
+	for (auto &band : queue->bands)
+	{
+		DrawerThread &thread = band->thread;
+		busy += thread.busy_time;
+		busyList.AppendFormat(" %2d", (int)MIN(thread.busy_time * 100.0 / elapsed, 99.0));
+		thread.busy_time = 0;
 	}
+
+	int workers = FThreadPool::Instance()->NumWorkers();
+	double total = elapsed * MAX(workers, 1);
+	out.Format("drawer bands=%d  workers=%d  busy=%04.1f%%  idle=%04.1f%%",
+		(int)queue->bands.size(), workers, busy * 100.0 / total, MAX(total - busy, 0.0) * 100.0 / total);
+	out.AppendFormat("\nbusy %% per band:%s", busyList.GetChars());
+	return out;
 }
 
-void DrawerThreads::StartThreads()
+void DrawerThreads::RunBand(DrawerBand *band)
 {
-	std::unique_lock<std::mutex> lock(threads_mutex);
+	std::unique_lock<std::mutex> lock(band->mutex);
+	while (true)
+	{
+		DrawerCommandQueuePtr list = std::move(band->pending.front());
+		band->pending.pop_front();
+		lock.unlock();
 
-	int num_numathreads = 0;
-	for (int i = 0; i < I_GetNumaNodeCount(); i++)
-		num_numathreads += I_GetNumaNodeThreadCount(i);
+		RunList(band, list);
+		list.reset();
 
-	int num_threads = num_numathreads;
-	if (num_threads == 0)
-		num_threads = 4;
+		lock.lock();
+		if (band->pending.empty())
+			break;
 
-	if (r_multithreaded == 0)
-		num_threads = 1;
-	else if (r_multithreaded != 1)
-		num_threads = r_multithreaded;
+		// The next list is still counted, so this cannot be the last task
+		FinishTask();
+	}
 
-	if (num_threads != (int)threads.size())
+	// The band may be freed as soon as the last task is finished
+	band->running = false;
+	lock.unlock();
+	FinishTask();
+}
+
+void DrawerThreads::RunList(DrawerBand *band, const DrawerCommandQueuePtr &list)
+{
+	DrawerThread *thread = &band->thread;
+	int num_bands = (int)bands.size();
+	thread->numa_start_y = band->index * screen->GetHeight() / num_bands;
+	thread->numa_end_y = (band->index + 1) * screen->GetHeight() / num_bands;
+	if (thread->poly)
 	{
-		StopThreads();
+		thread->poly->numa_start_y = thread->numa_start_y;
+		thread->poly->numa_end_y = thread->numa_end_y;
+	}
 
-		threads.resize(num_threads);
+	uint64_t start = I_nsTime();
 
-		if (num_threads == num_numathreads)
+	// Do the work:
+	if (r_debug_draw)
+	{
+		for (auto& command : list->commands)
 		{
-			int curThread = 0;
-			for (int numaNode = 0; numaNode < I_GetNumaNodeCount(); numaNode++)
-			{
-				for (int i = 0; i < I_GetNumaNodeThreadCount(numaNode); i++)
-				{
-					DrawerThreads *queue = this;
-					DrawerThread *thread = &threads[curThread++];
-					thread->core = i;
-					thread->num_cores = I_GetNumaNodeThreadCount(numaNode);
-					thread->numa_node = numaNode;
-					thread->num_numa_nodes = I_GetNumaNodeCount();
-					thread->thread = std::thread([=]() { queue->WorkerMain(thread); });
-					I_SetThreadNumaNode(thread->thread, numaNode);
-				}
-			}
+			thread->debug_draw_pos++;
+			if (thread->debug_draw_pos < debug_draw_end)
+				command->Execute(thread);
 		}
-		else
+	}
+	else
+	{
+		for (auto& command : list->commands)
 		{
-			for (int i = 0; i < num_threads; i++)
-			{
-				DrawerThreads *queue = this;
-				DrawerThread *thread = &threads[i];
-				thread->core = i;
-				thread->num_cores = num_threads;
-				thread->numa_node = 0;
-				thread->num_numa_nodes = 1;
-				thread->thread = std::thread([=]() { queue->WorkerMain(thread); });
-				I_SetThreadNumaNode(thread->thread, 0);
-			}
+			command->Execute(thread);
 		}
 	}
+
+	thread->busy_time += I_nsTime() - start;
 }
 
-void DrawerThreads::StopThreads()
+void DrawerThreads::FinishTask()
 {
-	std::unique_lock<std::mutex> lock(start_mutex);
-	shutdown_flag = true;
-	lock.unlock();
-	start_condition.notify_all();
-	for (auto &thread : threads)
-		thread.thread.join();
-	threads.clear();
-	lock.lock();
-	shutdown_flag = false;
+	// Notify main thread that we finished. Taking the lock orders the notify
+	// against a waiter that is about to park.
+	if (--tasks_left == 0)
+	{
+		std::unique_lock<std::mutex> end_lock(end_mutex);
+		end_lock.unlock();
+		end_condition.notify_all();
+	}
+}
+
+void DrawerThreads::SetupBands()
+{
+	// The thread pool is sized by the hardware. r_multithreaded only decides how
+	// many bands the screen is cut into; a couple per worker lets idle workers
+	// steal a band when the others are uneven.
+	int num_bands;
+	if (r_multithreaded == 1)
+		num_bands = FThreadPool::Instance()->NumWorkers() * 2;
+	else
+		num_bands = MAX((int)r_multithreaded, 1);
+
+	if (num_bands == (int)bands.size())
+		return;
+
+	bands.clear();
+	for (int i = 0; i < num_bands; i++)
+	{
+		bands.push_back(std::unique_ptr<DrawerBand>(new DrawerBand()));
+		bands.back()->index = i;
+	}
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -261,16 +313,6 @@ void *DrawerCommandQueue::AllocMemory(size_t size)
 
 /////////////////////////////////////////////////////////////////////////////
 
-void GroupMemoryBarrierCommand::Execute(DrawerThread *thread)
-{
-	std::unique_lock<std::mutex> lock(mutex);
-	count++;
-	condition.notify_all();
-	condition.wait(lock, [&]() { return count >= (size_t)thread->num_cores; });
-}
-
-/////////////////////////////////////////////////////////////////////////////
-
 MemcpyCommand::MemcpyCommand(void *dest, const void *src, int width, int height, int srcpitch, int pixelsize)
 	: dest(dest), src(src), width(width), height(height), srcpitch(srcpitch), pixelsize(pixelsize)
 {
@@ -292,3 +334,10 @@ void MemcpyCommand::Execute(DrawerThread *thread)
 		s += sstep;
 	}
 }
+
+/////////////////////////////////////////////////////////////////////////////
+
+ADD_STAT(drawers)
+{
+	return DrawerThreads::GetStats();
+}
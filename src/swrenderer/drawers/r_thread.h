@@ -23,10 +23,14 @@
 #pragma once
 
 #include "r_draw.h"
+#include "threadpool.h"
 #include <vector>
+#include <deque>
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 
 // Use multiple threads when drawing
@@ -34,26 +38,18 @@ EXTERN_CVAR(Int, r_multithreaded)
 
 class PolyTriangleThreadData;
 
-// Worker data for each thread executing drawer commands
+// Worker data for each band of the screen executing drawer commands
 class DrawerThread
 {
 public:
-	std::thread thread;
-	size_t current_queue = 0;
-
-	// Thread line index of this thread
+	// Thread line index of this thread. The drawer bands own a contiguous range
+	// of lines each, so this is always the first of one.
 	int core = 0;
 
-	// Number of active threads
+	// Number of threads the lines in the range are interleaved between
 	int num_cores = 1;
 
-	// NUMA node this thread belongs to
-	int numa_node = 0;
-
-	// Number of active NUMA nodes
-	int num_numa_nodes = 1;
-
-	// Active range for the numa block the cores are part of
+	// Range of lines owned by this thread
 	int numa_start_y = 0;
 	int numa_end_y = MAXHEIGHT;
 
@@ -64,6 +60,10 @@ public:
 
 	size_t debug_draw_pos = 0;
 
+	// Time spent executing command lists, in nanoseconds. Only written by the
+	// band's current worker; read by the drawers stat once the workers are idle.
+	uint64_t busy_time = 0;
+
 	// Checks if a line is rendered by this thread
 	bool line_skipped_by_thread(int line)
 	{
@@ -109,18 +109,6 @@ public:
 	virtual void Execute(DrawerThread *thread) = 0;
 };
 
-// Wait for all worker threads before executing next command
-class GroupMemoryBarrierCommand : public DrawerCommand
-{
-public:
-	void Execute(DrawerThread *thread);
-
-private:
-	std::mutex mutex;
-	std::condition_variable condition;
-	size_t count = 0;
-};
-
 // Copy finished rows to video memory
 class MemcpyCommand : public DrawerCommand
 {
@@ -150,28 +138,51 @@ public:
 	static void WaitForWorkers();
 
 	static void ResetDebugDrawPos();
+
+	// Per band busy and idle time since the last call
+	static FString GetStats();
+
+	// Pool task group of the drawer bands and scene slices. Threads waiting for
+	// a frame only help out with these.
+	static FThreadPool::TaskGroup TaskGroup() { return (FThreadPool::TaskGroup)Instance(); }
 	
 private:
 	DrawerThreads();
 	~DrawerThreads();
+
+	// A horizontal band of the screen. Its command lists are run as ordinary
+	// thread pool tasks, so any idle worker can pick the band up, but a band is
+	// only worked on by one worker at a time and runs its lists in order.
+	struct DrawerBand
+	{
+		int index = 0;
+		DrawerThread thread;
+		std::mutex mutex;
+		std::deque<DrawerCommandQueuePtr> pending;
+		bool running = false;
+	};
 	
-	void StartThreads();
-	void StopThreads();
-	void WorkerMain(DrawerThread *thread);
+	void SetupBands();
+	void RunBand(DrawerBand *band);
+	void RunList(DrawerBand *band, const DrawerCommandQueuePtr &list);
+	void FinishTask();
+	bool WaitForTasks(std::chrono::milliseconds timeout);
 
 	static DrawerThreads *Instance();
-	
-	std::mutex threads_mutex;
-	std::vector<DrawerThread> threads;
 
-	std::mutex start_mutex;
-	std::condition_variable start_condition;
-	std::vector<DrawerCommandQueuePtr> active_commands;
-	bool shutdown_flag = false;
+	// Only resized from WaitForWorkers, when no band is running
+	std::vector<std::unique_ptr<DrawerBand>> bands;
+
+	// Command lists handed out since the last WaitForWorkers, linked through
+	// DrawerCommandQueue::active_next. Scene threads push without locking.
+	std::atomic<DrawerCommandQueue *> active_commands { nullptr };
 
+	// Band runs still pending. The end mutex is only taken to park or wake a waiter.
+	std::atomic<int> tasks_left { 0 };
 	std::mutex end_mutex;
 	std::condition_variable end_condition;
-	size_t tasks_left = 0;
+
+	uint64_t stats_time = 0;
 
 	size_t debug_draw_end = 0;
 
@@ -213,6 +224,10 @@ private:
 	
 	std::vector<DrawerCommand *> commands;
 	RenderMemory *FrameMemory;
+
+	// Keeps the list alive while it is linked into DrawerThreads::active_commands
+	DrawerCommandQueue *active_next = nullptr;
+	DrawerCommandQueuePtr active_self;
 	
 	friend class DrawerThreads;
 };
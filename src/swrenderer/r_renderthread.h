@@ -79,8 +79,6 @@ namespace swrenderer
 
 		TArray<ADynamicLight*> AddedLightsArray;
 
-		std::thread thread;
-
 		// VisibleSprite working buffers
 		short clipbot[MAXWIDTH];
 		short cliptop[MAXWIDTH];
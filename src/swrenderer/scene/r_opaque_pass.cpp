@@ -614,9 +614,10 @@ namespace swrenderer
 		if ((unsigned int)(sub->Index()) < level.subsectors.Size())
 		{ // Only do it for the main BSP.
 			int lightlevel = (floorlightlevel + ceilinglightlevel) / 2;
-			for (int i = ParticlesInSubsec[sub->Index()]; i != NO_PARTICLE; i = Particles[i].snext)
+			int ssnum = sub->Index();
+			for (uint32_t j = ParticlesInSubsec[ssnum]; j < ParticlesInSubsec[ssnum + 1]; j++)
 			{
-				RenderParticle::Project(Thread, &Particles[i], sub->sector, lightlevel, FakeSide, foggy);
+				RenderParticle::Project(Thread, &Particles[ParticleBins[j]], sub->sector, lightlevel, FakeSide, foggy);
 			}
 		}
 
@@ -57,6 +57,7 @@
 #include "swrenderer/r_memory.h"
 #include "swrenderer/r_renderthread.h"
 #include "swrenderer/things/r_playersprite.h"
+#include "threadpool.h"
 #include <chrono>
 
 #ifdef WIN32
@@ -206,9 +207,8 @@ namespace swrenderer
 
 	void RenderScene::RenderThreadSlices()
 	{
-		int numThreads = std::thread::hardware_concurrency();
-		if (numThreads == 0)
-			numThreads = 4;
+		FThreadPool *pool = FThreadPool::Instance();
+		int numThreads = pool->NumWorkers();
 
 		if (r_scene_multithreaded == 0 || r_multithreaded == 0)
 			numThreads = 1;
@@ -222,7 +222,6 @@ namespace swrenderer
 		}
 
 		// Setup threads:
-		std::unique_lock<std::mutex> start_lock(start_mutex);
 		for (int i = 0; i < numThreads; i++)
 		{
 			*Threads[i]->Viewport = *MainThread()->Viewport;
@@ -230,32 +229,47 @@ namespace swrenderer
 			Threads[i]->X1 = viewwidth * i / numThreads;
 			Threads[i]->X2 = viewwidth * (i + 1) / numThreads;
 		}
-		run_id++;
-		start_lock.unlock();
 
-		// Notify threads to run
-		if (Threads.size() > 1)
+		// Hand the other slices to the thread pool:
+		finished_threads = 0;
+		for (int i = 1; i < numThreads; i++)
 		{
-			start_condition.notify_all();
+			RenderThread *thread = Threads[i].get();
+			pool->Submit([=]()
+			{
+				RenderThreadSlice(thread);
+
+				// Notify main thread that we finished:
+				std::unique_lock<std::mutex> end_lock(end_mutex);
+				finished_threads++;
+				end_lock.unlock();
+				end_condition.notify_all();
+			}, DrawerThreads::TaskGroup());
 		}
 
 		// Do the main thread ourselves:
 		RenderThreadSlice(MainThread());
 
-		// Wait for everyone to finish:
+		// Wait for everyone to finish, helping out with queued slices and drawer bands meanwhile:
 		if (Threads.size() > 1)
 		{
 			using namespace std::chrono_literals;
 			std::unique_lock<std::mutex> end_lock(end_mutex);
 			finished_threads++;
-			if (!end_condition.wait_for(end_lock, 5s, [&]() { return finished_threads == Threads.size(); }))
+			while (finished_threads != Threads.size())
 			{
+				end_lock.unlock();
+				bool helped = pool->RunQueuedTask(DrawerThreads::TaskGroup());
+				end_lock.lock();
+				if (!helped && !end_condition.wait_for(end_lock, 5s, [&]() { return finished_threads == Threads.size(); }))
+				{
 #ifdef WIN32
-				PeekThreadedErrorPane();
+					PeekThreadedErrorPane();
 #endif
-				// Invoke the crash reporter so that we can capture the call stack of whatever the hung worker thread is doing
-				int *threadCrashed = nullptr;
-				*threadCrashed = 0xdeadbeef;
+					// Invoke the crash reporter so that we can capture the call stack of whatever the hung worker thread is doing
+					int *threadCrashed = nullptr;
+					*threadCrashed = 0xdeadbeef;
+				}
 			}
 			finished_threads = 0;
 		}
@@ -319,50 +333,15 @@ namespace swrenderer
 
 	void RenderScene::StartThreads(size_t numThreads)
 	{
+		// The slices run as thread pool tasks, this only creates their state
 		while (Threads.size() < (size_t)numThreads)
-		{
-			std::unique_ptr<RenderThread> thread(new RenderThread(this, false));
-			auto renderthread = thread.get();
-			int start_run_id = run_id;
-			thread->thread = std::thread([=]()
-			{
-				int last_run_id = start_run_id;
-				while (true)
-				{
-					// Wait until we are signalled to run:
-					std::unique_lock<std::mutex> start_lock(start_mutex);
-					start_condition.wait(start_lock, [&]() { return run_id != last_run_id || shutdown_flag; });
-					if (shutdown_flag)
-						break;
-					last_run_id = run_id;
-					start_lock.unlock();
-
-					RenderThreadSlice(renderthread);
-
-					// Notify main thread that we finished:
-					std::unique_lock<std::mutex> end_lock(end_mutex);
-					finished_threads++;
-					end_lock.unlock();
-					end_condition.notify_all();
-				}
-			});
-			Threads.push_back(std::move(thread));
-		}
+			Threads.push_back(std::unique_ptr<RenderThread>(new RenderThread(this, false)));
 	}
 
 	void RenderScene::StopThreads()
 	{
-		std::unique_lock<std::mutex> lock(start_mutex);
-		shutdown_flag = true;
-		lock.unlock();
-		start_condition.notify_all();
 		while (Threads.size() > 1)
-		{
-			Threads.back()->thread.join();
 			Threads.pop_back();
-		}
-		lock.lock();
-		shutdown_flag = false;
 	}
 
 	void RenderScene::RenderViewToCanvas(AActor *actor, DCanvas *canvas, int x, int y, int width, int height, bool dontmaplines)
@@ -68,10 +68,6 @@ namespace swrenderer
 		int clearcolor = 0;
 
 		std::vector<std::unique_ptr<RenderThread>> Threads;
-		std::mutex start_mutex;
-		std::condition_variable start_condition;
-		bool shutdown_flag = false;
-		int run_id = 0;
 		std::mutex end_mutex;
 		std::condition_variable end_condition;
 		size_t finished_threads = 0;
@@ -54,9 +54,9 @@ namespace swrenderer
 		double TextureLOD() const { return ds_lod; }
 		RenderViewport *Viewport() const { return ds_viewport; }
 
-		FVector3 dc_normal;
-		FVector3 dc_viewpos;
-		FVector3 dc_viewpos_step;
+		FVector3 dc_normal = { 0.0f, 0.0f, 0.0f };
+		FVector3 dc_viewpos = { 0.0f, 0.0f, 0.0f };
+		FVector3 dc_viewpos_step = { 0.0f, 0.0f, 0.0f };
 		DrawerLight *dc_lights = nullptr;
 		int dc_num_lights = 0;
 
@@ -64,25 +64,25 @@ namespace swrenderer
 		typedef void(SWPixelFormatDrawers::*SpanDrawerFunc)(const SpanDrawerArgs &args);
 		SpanDrawerFunc spanfunc;
 
-		int ds_y;
-		int ds_x1;
-		int ds_x2;
-		int ds_texwidth;
-		int ds_texheight;
-		int ds_xbits;
-		int ds_ybits;
-		const uint8_t *ds_source;
-		bool ds_source_mipmapped;
-		uint32_t ds_xfrac;
-		uint32_t ds_yfrac;
-		uint32_t ds_xstep;
-		uint32_t ds_ystep;
-		uint32_t *dc_srcblend;
-		uint32_t *dc_destblend;
-		fixed_t dc_srcalpha;
-		fixed_t dc_destalpha;
+		int ds_y = 0;
+		int ds_x1 = 0;
+		int ds_x2 = 0;
+		int ds_texwidth = 0;
+		int ds_texheight = 0;
+		int ds_xbits = 0;
+		int ds_ybits = 0;
+		const uint8_t *ds_source = nullptr;
+		bool ds_source_mipmapped = false;
+		uint32_t ds_xfrac = 0;
+		uint32_t ds_yfrac = 0;
+		uint32_t ds_xstep = 0;
+		uint32_t ds_ystep = 0;
+		uint32_t *dc_srcblend = nullptr;
+		uint32_t *dc_destblend = nullptr;
+		fixed_t dc_srcalpha = 0;
+		fixed_t dc_destalpha = 0;
 		int ds_color = 0;
-		double ds_lod;
+		double ds_lod = 0.0;
 		RenderViewport *ds_viewport = nullptr;
 	};
 }
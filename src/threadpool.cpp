@@ -0,0 +1,254 @@
+/*
+**  Shared worker thread pool
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+*/
+
+#include <algorithm>
+#include "doomtype.h"
+#include "i_system.h"
+#include "threadpool.h"
+
+static thread_local int CurrentWorkerIndex = -1;
+
+/////////////////////////////////////////////////////////////////////////////
+
+FThreadPool *FThreadPool::Instance()
+{
+	static FThreadPool pool;
+	return &pool;
+}
+
+FThreadPool::~FThreadPool()
+{
+	std::unique_lock<std::mutex> lock(workers_mutex);
+	StopWorkers();
+}
+
+int FThreadPool::CurrentWorker()
+{
+	return CurrentWorkerIndex;
+}
+
+int FThreadPool::NumWorkers()
+{
+	std::unique_lock<std::mutex> lock(workers_mutex);
+	if (workers.empty())
+	{
+		// Default to one worker per hardware thread, grouped by NUMA node.
+		std::vector<int> numaNodes;
+		for (int node = 0; node < I_GetNumaNodeCount(); node++)
+		{
+			for (int i = 0; i < I_GetNumaNodeThreadCount(node); i++)
+				numaNodes.push_back(node);
+		}
+		if (numaNodes.empty())
+			numaNodes.resize(4, 0);
+		StartWorkers(numaNodes);
+	}
+	return (int)workers.size();
+}
+
+void FThreadPool::StartWorkers(const std::vector<int> &numaNodes)
+{
+	for (size_t i = 0; i < numaNodes.size(); i++)
+	{
+		workers.push_back(std::unique_ptr<Worker>(new Worker()));
+		workers.back()->numa_node = numaNodes[i];
+	}
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		Worker *worker = workers[i].get();
+		worker->thread = std::thread([=]() { WorkerMain((int)i); });
+		I_SetThreadNumaNode(worker->thread, worker->numa_node);
+	}
+}
+
+void FThreadPool::StopWorkers()
+{
+	// Workers only exit once all queued tasks have been run.
+	std::unique_lock<std::mutex> lock(wake_mutex);
+	shutdown_flag = true;
+	lock.unlock();
+	wake_condition.notify_all();
+	for (auto &worker : workers)
+		worker->thread.join();
+	workers.clear();
+	lock.lock();
+	shutdown_flag = false;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void FThreadPool::WakeWorkers()
+{
+	// Taking the lock orders this against a worker testing its wait condition.
+	std::unique_lock<std::mutex> lock(wake_mutex);
+	lock.unlock();
+	wake_condition.notify_all();
+}
+
+void FThreadPool::Submit(Task task, TaskGroup group)
+{
+	int count = NumWorkers();
+	int index = CurrentWorkerIndex;
+	if (index < 0 || index >= count)
+		index = next_worker++ % count;
+
+	Worker *worker = workers[index].get();
+	std::unique_lock<std::mutex> lock(worker->mutex);
+	worker->tasks.push_back({ std::move(task), group });
+	queued_tasks++;
+	lock.unlock();
+	WakeWorkers();
+}
+
+bool FThreadPool::RunQueuedTask(TaskGroup group)
+{
+	NumWorkers();
+	Task task;
+	if (group == 0 || !StealTask(CurrentWorkerIndex, group, task))
+		return false;
+	task();
+	return true;
+}
+
+bool FThreadPool::TakeTask(int index, Task &task)
+{
+	Worker *worker = workers[index].get();
+	std::unique_lock<std::mutex> lock(worker->mutex);
+	if (!worker->tasks.empty())
+	{
+		// Newest first from our own deque, it is most likely still in cache.
+		task = std::move(worker->tasks.back().task);
+		worker->tasks.pop_back();
+		queued_tasks--;
+		return true;
+	}
+	lock.unlock();
+	return StealTask(index, 0, task);
+}
+
+// Group 0 takes the oldest task of any group, which only the workers do.
+bool FThreadPool::StealTask(int thief, TaskGroup group, Task &task)
+{
+	if (queued_tasks == 0)
+		return false;
+
+	int count = (int)workers.size();
+	int start = thief < 0 ? 0 : thief + 1;
+	for (int i = 0; i < count; i++)
+	{
+		Worker *victim = workers[(start + i) % count].get();
+		std::unique_lock<std::mutex> lock(victim->mutex);
+		for (auto it = victim->tasks.begin(); it != victim->tasks.end(); ++it)
+		{
+			if (group == 0 || it->group == group)
+			{
+				task = std::move(it->task);
+				victim->tasks.erase(it);
+				queued_tasks--;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void FThreadPool::WorkerMain(int index)
+{
+	CurrentWorkerIndex = index;
+	while (true)
+	{
+		Task task;
+		if (TakeTask(index, task))
+		{
+			task();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(wake_mutex);
+		wake_condition.wait(lock, [&]() { return shutdown_flag || queued_tasks > 0; });
+		if (shutdown_flag && queued_tasks == 0)
+			break;
+	}
+
+	CurrentWorkerIndex = -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void FThreadPool::ParallelFor(int first, int last, int step, const std::function<void(int)> &body)
+{
+	if (last <= first)
+		return;
+
+	int count = (last - first + step - 1) / step;
+	int numWorkers = NumWorkers();
+	if (numWorkers <= 1 || count == 1)
+	{
+		for (int i = first; i < last; i += step)
+			body(i);
+		return;
+	}
+
+	struct Batch
+	{
+		std::atomic<int> remaining;
+		std::mutex mutex;
+		std::condition_variable done;
+	};
+
+	// A few chunks per worker so that stealing can even out uneven slices.
+	int numChunks = std::min(count, numWorkers * 4);
+	auto batch = std::make_shared<Batch>();
+	batch->remaining = numChunks;
+	TaskGroup group = (TaskGroup)batch.get();
+
+	for (int chunk = 0; chunk < numChunks; chunk++)
+	{
+		int begin = (int)((int64_t)chunk * count / numChunks);
+		int end = (int)((int64_t)(chunk + 1) * count / numChunks);
+		Submit([=, &body]()
+		{
+			for (int j = begin; j < end; j++)
+				body(first + j * step);
+
+			if (--batch->remaining == 0)
+			{
+				std::unique_lock<std::mutex> lock(batch->mutex);
+				batch->done.notify_all();
+			}
+		}, group);
+	}
+
+	// Help out with our own chunks instead of just sleeping.
+	int self = CurrentWorkerIndex;
+	while (batch->remaining > 0)
+	{
+		Task task;
+		if (StealTask(self, group, task))
+		{
+			task();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(batch->mutex);
+		batch->done.wait(lock, [&]() { return batch->remaining == 0; });
+	}
+}
@@ -0,0 +1,102 @@
+/*
+**  Shared worker thread pool
+**
+**  This software is provided 'as-is', without any express or implied
+**  warranty.  In no event will the authors be held liable for any damages
+**  arising from the use of this software.
+**
+**  Permission is granted to anyone to use this software for any purpose,
+**  including commercial applications, and to alter it and redistribute it
+**  freely, subject to the following restrictions:
+**
+**  1. The origin of this software must not be misrepresented; you must not
+**     claim that you wrote the original software. If you use this software
+**     in a product, an acknowledgment in the product documentation would be
+**     appreciated but is not required.
+**  2. Altered source versions must be plainly marked as such, and must not be
+**     misrepresented as being the original software.
+**  3. This notice may not be removed or altered from any source distribution.
+**
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+// Pool of worker threads shared by the drawers and any other parallel code.
+//
+// Every worker owns a deque of tasks. Tasks queued from a worker go to its own
+// deque; idle workers steal from the front of the other deques. The pool is
+// sized by the hardware once and never depends on what the tasks are for.
+//
+// A thread that waits for work it queued only helps out with tasks of its own
+// group, so it never picks up an unrelated long task in the middle of a frame.
+// Tasks of group 0 are only ever run by the workers.
+class FThreadPool
+{
+public:
+	typedef std::function<void()> Task;
+	typedef uintptr_t TaskGroup;
+
+	static FThreadPool *Instance();
+
+	// Number of worker threads, starting them with the default count if needed
+	int NumWorkers();
+
+	// Index of the calling worker, or -1 if called from a thread outside the pool
+	static int CurrentWorker();
+
+	// Queues a task that can be run by any worker
+	void Submit(Task task, TaskGroup group = 0);
+
+	// Runs one queued task of the given group on the calling thread, so that a
+	// thread waiting for work it queued can help out. Returns false if no task
+	// of that group was queued.
+	bool RunQueuedTask(TaskGroup group);
+
+	// Runs body(i) for first <= i < last in steps of 'step' and waits for all of
+	// them to finish. The calling thread helps out while waiting.
+	void ParallelFor(int first, int last, int step, const std::function<void(int)> &body);
+
+private:
+	FThreadPool() = default;
+	~FThreadPool();
+
+	struct QueuedTask
+	{
+		Task task;
+		TaskGroup group;
+	};
+
+	struct Worker
+	{
+		std::thread thread;
+		std::mutex mutex;
+		std::deque<QueuedTask> tasks;
+		int numa_node = 0;
+	};
+
+	void StartWorkers(const std::vector<int> &numaNodes);
+	void StopWorkers();
+	void WorkerMain(int index);
+	bool TakeTask(int index, Task &task);
+	bool StealTask(int thief, TaskGroup group, Task &task);
+	void WakeWorkers();
+
+	std::mutex workers_mutex;
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	std::mutex wake_mutex;
+	std::condition_variable wake_condition;
+	std::atomic<int> queued_tasks { 0 };
+	std::atomic<unsigned> next_worker { 0 };
+	bool shutdown_flag = false;
+};
@@ -216,7 +216,10 @@ void FWadCollection::AddFile (const char *filename, FileReader *wadr)
 
 		if (!isdir)
 		{
-			if (!wadreader.OpenFile(filename))
+			// Archives are mapped so that uncompressed lumps can be used in place
+			// instead of being read into a separate cache buffer.
+			bool opened = Args->CheckParm("-nommap") ? wadreader.OpenFile(filename) : wadreader.OpenMappedFile(filename);
+			if (!opened)
 			{ // Didn't find file
 				Printf (TEXTCOLOR_RED "%s: File not found\n", filename);
 				PrintLastError ();
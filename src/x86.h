@@ -21,6 +21,7 @@ struct CPUInfo	// 92 bytes
 	uint8_t Family;
 	uint8_t Type;
 	uint8_t HyperThreading;
+	uint8_t bAVX2;			// Also checks that the OS saves the YMM registers
 
 	union
 	{
@@ -37,7 +38,10 @@ struct CPUInfo	// 92 bytes
 			uint32_t DontCare1a:9;
 			uint32_t bSSE41:1;
 			uint32_t bSSE42:1;
-			uint32_t DontCare2a:11;
+			uint32_t DontCare2a:6;
+			uint32_t bOSXSAVE:1;
+			uint32_t bAVX:1;
+			uint32_t DontCare2b:3;
 
 			uint32_t bFPU:1;
 			uint32_t bVME:1;